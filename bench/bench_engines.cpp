@@ -0,0 +1,653 @@
+//  bench_engines.cpp: throughput and latency benchmarks for the engines and
+//  distributions in random_util.hpp.
+//
+//  Build from the repository root (there is no build system to drive it):
+//
+//      g++ -std=c++20 -O3 -march=native -pthread -o bench_engines
+//          bench/bench_engines.cpp                   (on one line)
+//
+//  -std=c++17 works too, minus the RandomView and RandomStream rows.
+//
+//  Usage:
+//      bench_engines [--quick] [--filter TEXT]
+//
+//      --quick        smaller buffers and shorter runs (for smoke tests)
+//      --filter TEXT  only run benchmarks whose name contains TEXT
+//
+//  Output:
+//
+//  Throughput table: one row per benchmark and buffer size, where the sizes
+//  step through roughly L1, L2, L3 and DRAM-resident buffers. Each row is
+//  the best of several timed repetitions of filling the whole buffer.
+//      Mval/s     million output values per second
+//      GB/s       output bytes per second
+//      ticks/val  timestamp counter ticks per value. On x86 this is the
+//                 TSC, which runs at the nominal clock rather than the
+//                 actual (turbo) core clock, so treat it as cycles at base
+//                 frequency. Elsewhere the column shows nanoseconds.
+//
+//  Latency table: one row per scalar call, timing every call individually
+//  with the timestamp counter. The cost of the timing itself (measured on
+//  an empty call) is subtracted, so values near zero are noise. p99.9 and
+//  max are where periodic work, such as the Mersenne Twister's twist of its
+//  whole state, shows up.
+//
+//  Every engine and distribution in the header has a row, except
+//  NumaBuffer, which is storage rather than a generator, and ThreadPool
+//  and SequentialExecutor, which appear only as the executors behind the
+//  parallel rows. Parallel rows scale with the hardware thread count
+//  printed at the top.
+//
+//  For stable numbers, pin the process (taskset -c 2 ./bench_engines) and
+//  disable frequency scaling.
+
+#include "../random_util.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+#endif
+
+namespace {
+
+    struct Options {
+        bool quick = false;
+        std::string filter;
+    };
+
+    Options gOptions;
+
+    auto Ticks() noexcept -> std::uint64_t {
+     #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+     #else
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+                ).count()
+            );
+     #endif
+    }
+
+    //  Keeps the compiler from discarding a value it can see is unused.
+    template<typename T>
+        void Keep(const T& value) noexcept {
+            asm volatile("" : : "r,m"(value) : "memory");
+        }
+
+    auto Selected(std::string_view name) -> bool {
+        return gOptions.filter.empty() ||
+            name.find(gOptions.filter) != std::string_view::npos;
+    }
+
+    auto BufferSizes() -> std::vector<std::size_t> {
+        if(gOptions.quick) {
+            return {4u << 10, 256u << 10, 4u << 20};
+        }
+        return {16u << 10, 512u << 10, 16u << 20, 256u << 20};
+    }
+
+    auto SizeLabel(std::size_t bytes) -> std::string {
+        char buf[32];
+        if(bytes >= 1u << 20) {
+            std::snprintf(buf, sizeof buf, "%zuM", bytes >> 20);
+        }
+        else {
+            std::snprintf(buf, sizeof buf, "%zuK", bytes >> 10);
+        }
+        return buf;
+    }
+
+    void PrintThroughputHeader() {
+        std::printf(
+            "\n%-44s %6s %10s %9s %10s\n", "throughput", "size", "Mval/s",
+            "GB/s", "ticks/val"
+            );
+    }
+
+    //  Times fill(out, n) over a buffer of each size, repeating until the
+    //  minimum run time is reached, and reports the best repetition.
+    template<typename T, typename Fill>
+        void Bulk(const char* name, Fill&& fill) {
+            if(!Selected(name)) { return; }
+            auto minTime = std::chrono::milliseconds{
+                gOptions.quick ? 20 : 200
+                };
+            for(auto bytes: BufferSizes()) {
+                auto n = std::max<std::size_t>(bytes / sizeof(T), 1);
+                std::vector<T> out(n);
+                fill(out.data(), n);  // warm up and fault in the pages
+                double bestSeconds = 1e300;
+                double bestTicks = 0.0;
+                auto start = std::chrono::steady_clock::now();
+                int reps = 0;
+                do {
+                    auto t0 = std::chrono::steady_clock::now();
+                    auto k0 = Ticks();
+                    fill(out.data(), n);
+                    auto k1 = Ticks();
+                    auto t1 = std::chrono::steady_clock::now();
+                    Keep(out[n / 2]);
+                    double s = std::chrono::duration<double>(t1 - t0).count();
+                    if(s < bestSeconds) {
+                        bestSeconds = s;
+                        bestTicks = static_cast<double>(k1 - k0);
+                    }
+                    ++reps;
+                } while(
+                    reps < 3 ||
+                    std::chrono::steady_clock::now() - start < minTime
+                    );
+                auto values = static_cast<double>(n);
+                std::printf(
+                    "%-44s %6s %10.1f %9.2f %10.2f\n", name,
+                    SizeLabel(bytes).c_str(), values / bestSeconds * 1e-6,
+                    values * sizeof(T) / bestSeconds * 1e-9,
+                    bestTicks / values
+                    );
+            }
+        }
+
+    void PrintLatencyHeader() {
+        std::printf(
+            "\n%-44s %10s %8s %8s %8s %8s %8s\n", "latency (ticks/call)",
+            "Mcall/s", "p50", "p90", "p99", "p99.9", "max"
+            );
+    }
+
+    //  Calls call() many times, first back to back for throughput and then
+    //  one at a time between timestamp reads for the latency distribution.
+    template<typename Call>
+        void Scalar(const char* name, Call&& call) {
+            if(!Selected(name)) { return; }
+            const std::size_t kCalls = gOptions.quick ? 200'000 : 4'000'000;
+            const std::size_t kSamples = gOptions.quick ? 100'000 : 1'000'000;
+
+            for(std::size_t i = 0; i < kCalls / 10; ++i) { Keep(call()); }
+            auto t0 = std::chrono::steady_clock::now();
+            for(std::size_t i = 0; i < kCalls; ++i) { Keep(call()); }
+            auto t1 = std::chrono::steady_clock::now();
+            double rate = static_cast<double>(kCalls) /
+                std::chrono::duration<double>(t1 - t0).count();
+
+            //  The overhead of the timestamp pair itself.
+            std::vector<std::uint64_t> lat(kSamples);
+            for(auto& l: lat) {
+                auto k0 = Ticks();
+                auto k1 = Ticks();
+                l = k1 - k0;
+            }
+            std::sort(lat.begin(), lat.end());
+            auto overhead = lat[lat.size() / 2];
+
+            for(auto& l: lat) {
+                auto k0 = Ticks();
+                Keep(call());
+                auto k1 = Ticks();
+                l = k1 - k0;
+            }
+            std::sort(lat.begin(), lat.end());
+            auto pct = [&](double p) -> long long {
+                auto size = static_cast<double>(lat.size());
+                auto i = std::min(
+                    lat.size() - 1, static_cast<std::size_t>(p * size)
+                    );
+                auto v = static_cast<long long>(lat[i]) -
+                    static_cast<long long>(overhead);
+                return std::max(v, 0ll);
+            };
+            std::printf(
+                "%-44s %10.1f %8lld %8lld %8lld %8lld %8lld\n", name,
+                rate * 1e-6, pct(0.5), pct(0.9), pct(0.99), pct(0.999),
+                pct(1.0)
+                );
+        }
+
+    //  Reads a 32- or 64-bit engine into a buffer of 64-bit words.
+    template<typename URBG>
+        void FillWords(URBG& g, std::uint64_t* out, std::size_t n) {
+            for(std::size_t i = 0; i < n; ++i) {
+                out[i] = RandomUtilDetail::Bits64(g);
+            }
+        }
+
+    void EngineThroughput() {
+        PrintThroughputHeader();
+        SeedSource::Seq mtSeq;
+        std::mt19937 mt32{mtSeq};
+        Bulk<std::uint32_t>("std::mt19937 raw", [&](auto* out, auto n) {
+            for(std::size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<std::uint32_t>(mt32());
+            }
+        });
+        auto mt = MakeMTEngine();
+        Bulk<std::uint64_t>("MTEngineT raw", [&](auto* out, auto n) {
+            FillWords(mt, out, n);
+        });
+        auto imt = MakeIncrementalMTEngine();
+        Bulk<std::uint64_t>("IncrementalMTEngineT raw",
+            [&](auto* out, auto n) {
+                FillWords(imt, out, n);
+            });
+        Philox4x32 philox{SeedSource::Seq{}};
+        Bulk<std::uint64_t>("Philox4x32 raw", [&](auto* out, auto n) {
+            FillWords(philox, out, n);
+        });
+        Bulk<std::uint64_t>("GlobalEngine (PerCpuEngine) raw",
+            [&](auto* out, auto n) {
+                auto& g = GlobalEngine();
+                FillWords(g, out, n);
+            });
+        Bulk<std::uint64_t>("ThreadEngine raw", [&](auto* out, auto n) {
+            FillWords(ThreadEngine(), out, n);
+        });
+        SharedRandom shared{SeedSource::Seq{}};
+        SharedRandom::Reader reader{shared};
+        Bulk<std::uint64_t>("SharedRandom::Reader raw",
+            [&](auto* out, auto n) {
+                FillWords(reader, out, n);
+            });
+        if(Selected("RandomService")) {
+            RandomService<> service{1, {}, 1u << 16};
+            auto& consumer = service.consumer(0);
+            Bulk<std::uint64_t>("RandomService consumer raw",
+                [&](auto* out, auto n) {
+                    FillWords(consumer, out, n);
+                });
+        }
+    }
+
+    void DistributionThroughput() {
+        PrintThroughputHeader();
+        auto mt = MakeMTEngine();
+        auto seq = SeedSource::SpawnSeq::FromKey(1);
+
+        Bulk<double>("uniform_real<double> scalar loop",
+            [&](auto* out, auto n) {
+                std::uniform_real_distribution<double> dis;
+                for(std::size_t i = 0; i < n; ++i) { out[i] = dis(mt); }
+            });
+        Bulk<double>("normal<double> scalar loop", [&](auto* out, auto n) {
+            std::normal_distribution<double> dis;
+            for(std::size_t i = 0; i < n; ++i) { out[i] = dis(mt); }
+        });
+        Bulk<double>("normal<double> ParallelFill sequential",
+            [&](auto* out, auto n) {
+                ParallelFill(
+                    out, out + n, std::normal_distribution<double>{}, seq,
+                    SequentialExecutor{}
+                    );
+            });
+        Bulk<double>("normal<double> ParallelFill pool",
+            [&](auto* out, auto n) {
+                ParallelFill(
+                    out, out + n, std::normal_distribution<double>{}, seq
+                    );
+            });
+        Bulk<double>("normal<double> FillAsync pool", [&](auto* out, auto n) {
+            FillAsync(
+                out, out + n, std::normal_distribution<double>{}, seq
+                ).get();
+        });
+     #if RANDOM_UTIL_HAS_RANGES
+        Bulk<double>("normal<double> RandomView", [&](auto* out, auto n) {
+            RandomView view{mt, std::normal_distribution<double>{}};
+            auto it = view.begin();
+            for(std::size_t i = 0; i < n; ++i, ++it) { out[i] = *it; }
+        });
+     #endif
+     #if RANDOM_UTIL_HAS_COROUTINES
+        Bulk<double>("normal<double> RandomStream", [&](auto* out, auto n) {
+            auto stream = RandomStream(mt, std::normal_distribution<double>{});
+            auto it = stream.begin();
+            for(std::size_t i = 0; i < n; ++i, ++it) { out[i] = *it; }
+        });
+     #endif
+
+        Bulk<std::byte>("FillBytes", [&](auto* out, auto n) {
+            FillBytes(mt, out, out + n);
+        });
+        Bulk<char>("RandomString base62", [&](auto* out, auto n) {
+            constexpr std::string_view kBase62 =
+                "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                "abcdefghijklmnopqrstuvwxyz";
+            RandomString(mt, kBase62, n, out);
+        });
+        Bulk<char>("Uuid::FormatV4 (per char)", [&](auto* out, auto n) {
+            for(std::size_t i = 0; i + Uuid::kTextSize <= n;) {
+                Uuid::FormatV4(mt, out + i);
+                i += Uuid::kTextSize;
+            }
+        });
+
+        using LowPrecision::BFloat16;
+        using LowPrecision::Float16;
+        using LowPrecision::Float8E4M3;
+        using LowPrecision::Float8E5M2;
+        Bulk<BFloat16>("LowPrecision::FillUniform bf16",
+            [&](auto* out, auto n) {
+                LowPrecision::FillUniform(mt, out, out + n);
+            });
+        Bulk<BFloat16>("LowPrecision::FillNormal bf16",
+            [&](auto* out, auto n) {
+                LowPrecision::FillNormal(mt, out, out + n);
+            });
+        Bulk<Float8E4M3>("LowPrecision::FillNormal fp8 e4m3",
+            [&](auto* out, auto n) {
+                LowPrecision::FillNormal(mt, out, out + n);
+            });
+        Bulk<Float16>("LowPrecision::FillUniform fp16",
+            [&](auto* out, auto n) {
+                LowPrecision::FillUniform(mt, out, out + n);
+            });
+        Bulk<Float16>("LowPrecision::FillNormal fp16",
+            [&](auto* out, auto n) {
+                LowPrecision::FillNormal(mt, out, out + n);
+            });
+        Bulk<Float8E5M2>("LowPrecision::FillNormal fp8 e5m2",
+            [&](auto* out, auto n) {
+                LowPrecision::FillNormal(mt, out, out + n);
+            });
+        {
+            //  Conversions alone, from a fixed buffer of floats.
+            std::vector<float> src;
+            auto source = [&](std::size_t n) -> const float* {
+                if(src.size() != n) {
+                    src.resize(n);
+                    std::normal_distribution<float> dis;
+                    for(auto& x: src) { x = dis(mt); }
+                }
+                return src.data();
+            };
+            Bulk<Float16>("LowPrecision::Float16::FromFloat",
+                [&](auto* out, auto n) {
+                    auto in = source(n);
+                    for(std::size_t i = 0; i < n; ++i) {
+                        out[i] = Float16::FromFloat(in[i]);
+                    }
+                });
+            Bulk<Float8E5M2>("LowPrecision::Float8E5M2::FromFloat",
+                [&](auto* out, auto n) {
+                    auto in = source(n);
+                    for(std::size_t i = 0; i < n; ++i) {
+                        out[i] = Float8E5M2::FromFloat(in[i]);
+                    }
+                });
+            std::vector<Float16> half;
+            Bulk<float>("LowPrecision::Float16 to float",
+                [&](auto* out, auto n) {
+                    if(half.size() != n) {
+                        auto in = source(n);
+                        half.resize(n);
+                        for(std::size_t i = 0; i < n; ++i) {
+                            half[i] = Float16::FromFloat(in[i]);
+                        }
+                    }
+                    for(std::size_t i = 0; i < n; ++i) {
+                        out[i] = static_cast<float>(half[i]);
+                    }
+                });
+        }
+        {
+            std::vector<float> src;
+            Bulk<std::int8_t>("LowPrecision::StochasticRound int8",
+                [&](auto* out, auto n) {
+                    if(src.size() != n) {
+                        src.assign(n, 0.0f);
+                        for(std::size_t i = 0; i < n; ++i) {
+                            src[i] = static_cast<float>(i % 255) - 127.3f;
+                        }
+                    }
+                    LowPrecision::StochasticRound(
+                        mt, src.begin(), src.end(), out
+                        );
+                });
+        }
+        Bulk<float>("AddNoise Gaussian float", [&](auto* out, auto n) {
+            AddNoise(mt, out, out + n, Noise::Gaussian{0.0, 1.0});
+        });
+        Bulk<float>("AddNoise Laplace float", [&](auto* out, auto n) {
+            AddNoise(mt, out, out + n, Noise::Laplace{0.0, 1.0});
+        });
+
+        QuasiRandom::Sobol sobol{8, QuasiRandom::kOwenScrambling};
+        Bulk<double>("QuasiRandom::Sobol 8-d Owen", [&](auto* out, auto n) {
+            sobol.seek(0);
+            sobol.generate(out, out + n / 8 * 8);
+        });
+        QuasiRandom::Halton halton{8, QuasiRandom::kDigitalShift};
+        Bulk<double>("QuasiRandom::Halton 8-d shifted",
+            [&](auto* out, auto n) {
+                halton.seek(0);
+                halton.generate(out, out + n / 8 * 8);
+            });
+        QuasiRandom::Halton haltonOwen{8, QuasiRandom::kOwenScrambling};
+        Bulk<double>("QuasiRandom::Halton 8-d Owen", [&](auto* out, auto n) {
+            haltonOwen.seek(0);
+            haltonOwen.generate(out, out + n / 8 * 8);
+        });
+        QuasiRandom::Sobol sobolPlain{8};
+        Bulk<double>("QuasiRandom::Sobol 8-d unscrambled",
+            [&](auto* out, auto n) {
+                sobolPlain.seek(0);
+                sobolPlain.generate(out, out + n / 8 * 8);
+            });
+        QuasiRandom::RSequence rseq{8};
+        Bulk<double>("QuasiRandom::RSequence 8-d", [&](auto* out, auto n) {
+            rseq.seek(0);
+            rseq.generate(out, out + n / 8 * 8);
+        });
+
+        Bulk<std::uint64_t>("RandomPermutation::permute batch",
+            [&](auto* out, auto n) {
+                RandomPermutation perm{std::uint64_t{1} << 40, seq};
+                perm.permute(0, n, out);
+            });
+        Bulk<double>("Sampling::LatinHypercube 4-d", [&](auto* out, auto n) {
+            Sampling::LatinHypercube lhs{std::max<std::size_t>(n / 4, 1), 4};
+            lhs.generate(mt, out);
+        });
+        Bulk<double>("Sampling::JitteredGrid 2-d", [&](auto* out, auto n) {
+            auto strata = static_cast<std::size_t>(
+                std::sqrt(static_cast<double>(n / 2))
+                );
+            Sampling::JitteredGrid grid{std::max<std::size_t>(strata, 1), 2};
+            grid.generate(mt, out);
+        });
+        Bulk<float>("Geometric::OnSphere 3-d (per coord)",
+            [&](auto* out, auto n) {
+                auto count = n / 3;
+                float* axes[] = {out, out + count, out + 2 * count};
+                Geometric::OnSphere(mt, count, 3, axes);
+            });
+        Bulk<float>("Geometric::InBall 3-d (per coord)",
+            [&](auto* out, auto n) {
+                auto count = n / 3;
+                float* axes[] = {out, out + count, out + 2 * count};
+                Geometric::InBall(mt, count, 3, axes);
+            });
+        Bulk<float>("Geometric::OnSimplex 4-d (per coord)",
+            [&](auto* out, auto n) {
+                auto count = n / 4;
+                float* axes[] = {
+                    out, out + count, out + 2 * count, out + 3 * count
+                    };
+                Geometric::OnSimplex(mt, count, 4, axes);
+            });
+        Bulk<float>("Geometric::InSimplex 4-d (per coord)",
+            [&](auto* out, auto n) {
+                auto count = n / 4;
+                float* axes[] = {
+                    out, out + count, out + 2 * count, out + 3 * count
+                    };
+                Geometric::InSimplex(mt, count, 4, axes);
+            });
+        Bulk<float>("Geometric::Quaternions (per component)",
+            [&](auto* out, auto n) {
+                auto count = n / 4;
+                float* wxyz[] = {
+                    out, out + count, out + 2 * count, out + 3 * count
+                    };
+                Geometric::Quaternions(mt, count, wxyz);
+            });
+        Bulk<float>("Geometric::Rotations3 (per element)",
+            [&](auto* out, auto n) {
+                auto count = n / 9;
+                float* m[9];
+                for(std::size_t k = 0; k < 9; ++k) { m[k] = out + k * count; }
+                Geometric::Rotations3(mt, count, m);
+            });
+        {
+            std::vector<double> cov(64, 0.5);
+            for(std::size_t i = 0; i < 8; ++i) { cov[i * 9] = 1.0; }
+            MultivariateNormal mvn{std::vector<double>(8, 0.0), cov};
+            Bulk<double>("MultivariateNormal 8-d (per coord)",
+                [&](auto* out, auto n) {
+                    mvn.generate(mt, out, n / 8);
+                });
+        }
+        Bulk<std::uint32_t>("Shuffle sequential", [&](auto* out, auto n) {
+            Shuffle(out, out + n, seq, SequentialExecutor{});
+        });
+        Bulk<std::uint32_t>("Shuffle pool", [&](auto* out, auto n) {
+            Shuffle(out, out + n, seq);
+        });
+        {
+            //  Draws k of 16 k in runs of at most kMaxK, so that the source
+            //  stays at 64 MiB however large the output buffer is.
+            constexpr std::size_t kMaxK = 1u << 20;
+            std::vector<std::uint32_t> src;
+            Bulk<std::uint32_t>("Sample k of 16 k, k <= 1Mi (per output)",
+                [&](auto* out, auto n) {
+                    for(std::size_t i = 0; i < n; i += kMaxK) {
+                        auto k = std::min(kMaxK, n - i);
+                        src.resize(k * 16);
+                        Sample(
+                            src.begin(), src.end(), out + i, k, seq,
+                            SequentialExecutor{}
+                            );
+                    }
+                });
+        }
+    }
+
+    //  MonteCarlo::Run has no output buffer, so its rows count kernel
+    //  samples over a nominal buffer of doubles and store only the result.
+    void MonteCarloThroughput() {
+        PrintThroughputHeader();
+        auto seq = SeedSource::SpawnSeq::FromKey(1);
+        auto pi = [](MTEngineT& g) {
+            std::uniform_real_distribution<double> dis;
+            double x = dis(g), y = dis(g);
+            return x * x + y * y < 1.0 ? 4.0 : 0.0;
+        };
+        Bulk<double>("MonteCarlo::Run pi sequential (per sample)",
+            [&](auto* out, auto n) {
+                auto stats = MonteCarlo::Run(
+                    n, pi, MonteCarlo::Stats{}, seq, SequentialExecutor{}
+                    );
+                out[n / 2] = stats.mean();
+            });
+        Bulk<double>("MonteCarlo::Run pi pool (per sample)",
+            [&](auto* out, auto n) {
+                auto stats = MonteCarlo::Run(
+                    n, pi, MonteCarlo::Stats{}, seq
+                    );
+                out[n / 2] = stats.mean();
+            });
+    }
+
+    void ScalarLatency() {
+        PrintLatencyHeader();
+        Scalar("Ticks() (empty call)", [] { return 0; });
+        SeedSource::Seq mtSeq;
+        std::mt19937 mt32{mtSeq};
+        Scalar("std::mt19937()", [&] { return mt32(); });
+        auto mt = MakeMTEngine();
+        Scalar("MTEngineT()", [&] { return mt(); });
+        IncrementalMT19937 imt32{SeedSource::Seq{}};
+        Scalar("IncrementalMT19937()", [&] { return imt32(); });
+        auto imt = MakeIncrementalMTEngine();
+        Scalar("IncrementalMTEngineT()", [&] { return imt(); });
+        Philox4x32 philox{SeedSource::Seq{}};
+        Scalar("Philox4x32()", [&] { return philox(); });
+        Scalar("GlobalEngine()()", [] { return GlobalEngine()(); });
+        Scalar("ThreadEngine()()", [] { return ThreadEngine()(); });
+        SharedRandom shared{SeedSource::Seq{}};
+        SharedRandom::Reader reader{shared};
+        Scalar("SharedRandom::Reader()", [&] { return reader(); });
+        if(Selected("RandomService")) {
+            RandomService<> service{1, {}, 1u << 16};
+            auto& consumer = service.consumer(0);
+            Scalar("RandomService consumer pop()", [&] {
+                return consumer.pop();
+            });
+        }
+     #if RANDOM_UTIL_HAS_POSIX
+        if(Selected("InterprocessRandom")) {
+            const char* name = "/random_util_bench";
+            InterprocessRandom::Remove(name);
+            {
+                InterprocessRandom ipc{name};
+                InterprocessRandom::Reader ipcReader{ipc};
+                Scalar("InterprocessRandom::Reader()", [&] {
+                    return ipcReader();
+                });
+            }
+            InterprocessRandom::Remove(name);
+        }
+     #endif
+        Scalar("RandomInt(1, 6)", [] { return RandomInt(1, 6); });
+        Scalar("RandomReal()", [] { return RandomReal(); });
+        Scalar("RandomBool()", [] { return RandomBool(); });
+        std::normal_distribution<double> normal;
+        Scalar("normal<double>(MTEngineT)", [&] { return normal(mt); });
+        Scalar("normal<double>(IncrementalMTEngineT)", [&] {
+            return normal(imt);
+        });
+        Scalar("Uuid::V4", [&] { return Uuid::V4(mt); });
+        Scalar("Uuid::V7", [&] { return Uuid::V7(mt); });
+        RandomPermutation perm{std::uint64_t{1} << 40};
+        std::uint64_t permIndex = 0;
+        Scalar("RandomPermutation::permute(i)", [&] {
+            return perm.permute(permIndex++);
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--quick") == 0) {
+            gOptions.quick = true;
+        }
+        else if(std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            gOptions.filter = argv[++i];
+        }
+        else {
+            std::fprintf(
+                stderr, "usage: %s [--quick] [--filter TEXT]\n", argv[0]
+                );
+            return 2;
+        }
+    }
+    std::printf(
+        "random_util benchmarks (%u hardware threads, ticks = %s)\n",
+        std::thread::hardware_concurrency(),
+     #if defined(__x86_64__) || defined(__i386__)
+        "TSC"
+     #else
+        "ns"
+     #endif
+        );
+    EngineThroughput();
+    DistributionThroughput();
+    MonteCarloThroughput();
+    ScalarLatency();
+    return 0;
+}
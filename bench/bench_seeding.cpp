@@ -0,0 +1,527 @@
+//  bench_seeding.cpp: latency, allocation and system call costs of seeding
+//  with random_util.hpp.
+//
+//  Build from the repository root (there is no build system to drive it):
+//
+//      g++ -std=c++17 -O2 -pthread -o bench_seeding
+//          bench/bench_seeding.cpp -ldl               (on one line)
+//
+//  Link dynamically: the system call counts rely on interposing libc
+//  functions, which does not work in a static binary.
+//
+//  Usage:
+//      bench_seeding [--quick] [--threads N] [--filter TEXT]
+//
+//      --quick        fewer samples and cold runs (for smoke tests)
+//      --threads N    threads for the contended table (default: the
+//                     hardware thread count, at least 2)
+//      --filter TEXT  only run operations whose name contains TEXT
+//
+//  Every seeding operation is run for each combination of the
+//  SeedSource::kRandomDevice, kSystemClock and kSteadyClock flags where it
+//  takes flags, including none at all.
+//
+//  Output columns:
+//      cold       median wall time in ns of the first call in a freshly
+//                 exec'd process, which pays for first use of the random
+//                 device, the vDSO clocks, lazy symbol binding and so on
+//      p50, p99   warm wall time percentiles in ns over repeated calls
+//      allocs     calls to operator new per call, counted by replacing the
+//                 global operator new
+//      getrandom, open, read
+//                 calls per call to these libc functions, counted by
+//                 interposing them (Linux/glibc only). These count libc
+//                 entry points, not kernel system calls: a call glibc makes
+//                 internally (fopen's own open, fread's own read) or a
+//                 random device that uses the RDRAND/RDSEED instructions
+//                 shows up as zero, so read them as a lower bound. fopen is
+//                 counted under open for that reason.
+//
+//  The second table repeats the warm measurements with that many threads
+//  seeding at once, which is where shared state such as the random device
+//  or ThreadEngine's process-wide root shows contention.
+
+#include "../random_util.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__) && defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <sys/random.h>
+ #define BENCH_INTERPOSE 1
+#else
+ #define BENCH_INTERPOSE 0
+#endif
+
+#if RANDOM_UTIL_HAS_POSIX
+ #include <sys/wait.h>
+#endif
+
+namespace {
+
+    //  Per-thread so that each thread's counts are its own and so that
+    //  counting needs no synchronization.
+    struct Counts {
+        std::uint64_t allocs = 0;
+        std::uint64_t getrandom = 0;
+        std::uint64_t opens = 0;
+        std::uint64_t reads = 0;
+    };
+
+    thread_local Counts tCounts;
+
+    auto operator-(const Counts& a, const Counts& b) -> Counts {
+        return {
+            a.allocs - b.allocs, a.getrandom - b.getrandom,
+            a.opens - b.opens, a.reads - b.reads
+            };
+    }
+}
+
+//---- Allocation counting ----------------------------------------------------
+
+void* operator new(std::size_t n) {
+    ++tCounts.allocs;
+    if(void* p = std::malloc(n ? n : 1)) { return p; }
+    throw std::bad_alloc{};
+}
+void* operator new[](std::size_t n) { return ::operator new(n); }
+void* operator new(std::size_t n, std::align_val_t a) {
+    ++tCounts.allocs;
+    auto align = static_cast<std::size_t>(a);
+    auto size = (std::max<std::size_t>(n, 1) + align - 1) / align * align;
+    if(void* p = std::aligned_alloc(align, size)) { return p; }
+    throw std::bad_alloc{};
+}
+void* operator new[](std::size_t n, std::align_val_t a) {
+    return ::operator new(n, a);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+//---- libc call counting -----------------------------------------------------
+
+#if BENCH_INTERPOSE
+namespace {
+    template<typename Fn>
+        auto Next(const char* name) -> Fn* {
+            return reinterpret_cast<Fn*>(dlsym(RTLD_NEXT, name));
+        }
+}
+
+extern "C" {
+    ssize_t getrandom(void* buf, size_t n, unsigned flags) {
+        static auto real = Next<decltype(::getrandom)>("getrandom");
+        ++tCounts.getrandom;
+        return real(buf, n, flags);
+    }
+    ssize_t read(int fd, void* buf, size_t n) {
+        static auto real = Next<decltype(::read)>("read");
+        ++tCounts.reads;
+        return real(fd, buf, n);
+    }
+    int open(const char* path, int flags, ...) {
+        static auto real = Next<int(const char*, int, ...)>("open");
+        ++tCounts.opens;
+        va_list args;
+        va_start(args, flags);
+        auto mode = va_arg(args, mode_t);
+        va_end(args);
+        return real(path, flags, mode);
+    }
+    int open64(const char* path, int flags, ...) {
+        static auto real = Next<int(const char*, int, ...)>("open64");
+        ++tCounts.opens;
+        va_list args;
+        va_start(args, flags);
+        auto mode = va_arg(args, mode_t);
+        va_end(args);
+        return real(path, flags, mode);
+    }
+    int openat(int dir, const char* path, int flags, ...) {
+        static auto real = Next<int(int, const char*, int, ...)>("openat");
+        ++tCounts.opens;
+        va_list args;
+        va_start(args, flags);
+        auto mode = va_arg(args, mode_t);
+        va_end(args);
+        return real(dir, path, flags, mode);
+    }
+    FILE* fopen(const char* path, const char* mode) {
+        static auto real = Next<decltype(::fopen)>("fopen");
+        ++tCounts.opens;
+        return real(path, mode);
+    }
+}
+#endif
+
+namespace {
+
+    struct Options {
+        bool quick = false;
+        unsigned threads = 0;
+        std::string filter;
+        std::string self;
+    };
+
+    Options gOptions;
+
+    //  Keeps the compiler from discarding a value it can see is unused.
+    template<typename T>
+        void Keep(const T& value) noexcept {
+            asm volatile("" : : "r,m"(value) : "memory");
+        }
+
+    struct Sample {
+        std::int64_t ns;
+        Counts counts;
+    };
+
+    //  Times fn() on the calling thread.
+    template<typename Fn>
+        auto Time(Fn&& fn) -> Sample {
+            auto c0 = tCounts;
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            auto t1 = std::chrono::steady_clock::now();
+            auto c1 = tCounts;
+            return {
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    t1 - t0
+                    ).count(),
+                c1 - c0
+                };
+        }
+
+    struct Operation {
+        const char* name;
+        bool takesFlags;
+        Sample (*run)(SeedSource::Flags flags);
+    };
+
+    const Operation kOperations[] = {
+        {"Seq::generate 8 words", true, [](SeedSource::Flags f) {
+            std::array<SeedSource::Seq::result_type,8> words;
+            auto s = Time([&] {
+                SeedSource::Seq{f}.generate(words.begin(), words.end());
+            });
+            Keep(words);
+            return s;
+        }},
+        {"Seq::generate 624 words", true, [](SeedSource::Flags f) {
+            std::array<SeedSource::Seq::result_type,624> words;
+            auto s = Time([&] {
+                SeedSource::Seq{f}.generate(words.begin(), words.end());
+            });
+            Keep(words);
+            return s;
+        }},
+        {"MakeMTEngine", true, [](SeedSource::Flags f) {
+            return Time([&] { Keep(MakeMTEngine(f)()); });
+        }},
+        {"MakeIncrementalMTEngine", true, [](SeedSource::Flags f) {
+            return Time([&] { Keep(MakeIncrementalMTEngine(f)()); });
+        }},
+        {"SpawnSeq root from Seq", true, [](SeedSource::Flags f) {
+            return Time([&] {
+                SeedSource::SpawnSeq root{SeedSource::Seq{f}};
+                Keep(root.key);
+            });
+        }},
+        {"SpawnSeq::spawn -> MTEngineT", false, [](SeedSource::Flags) {
+            static std::atomic<std::uint64_t> index{0};
+            auto root = SeedSource::SpawnSeq::FromKey(1);
+            auto i = index.fetch_add(1, std::memory_order_relaxed);
+            return Time([&] {
+                auto child = root.spawn(i);
+                MTEngineT g{child};
+                Keep(g());
+            });
+        }},
+        {"Philox4x32 from Seq", true, [](SeedSource::Flags f) {
+            return Time([&] {
+                SeedSource::Seq seq{f};
+                Philox4x32 g{seq};
+                Keep(g());
+            });
+        }},
+
+        //  Each sample starts a new thread and times only its first
+        //  ThreadEngine() call, inside that thread.
+        {"ThreadEngine first call", false, [](SeedSource::Flags) {
+            Sample s{};
+            std::thread t{[&] {
+                s = Time([] { Keep(ThreadEngine()()); });
+            }};
+            t.join();
+            return s;
+        }},
+    };
+
+    auto Selected(const Operation& op) -> bool {
+        return gOptions.filter.empty() ||
+            std::string_view{op.name}.find(gOptions.filter) !=
+                std::string_view::npos;
+    }
+
+    auto FlagsLabel(SeedSource::Flags f) -> std::string {
+        std::string s;
+        auto add = [&](SeedSource::Flags bit, const char* name) {
+            if(f & bit) {
+                if(!s.empty()) { s += '+'; }
+                s += name;
+            }
+        };
+        add(SeedSource::kRandomDevice, "rd");
+        add(SeedSource::kSystemClock, "sys");
+        add(SeedSource::kSteadyClock, "steady");
+        return s.empty() ? "none" : s;
+    }
+
+    auto Percentile(std::vector<std::int64_t>& v, double p) -> std::int64_t {
+        if(v.empty()) { return 0; }
+        std::sort(v.begin(), v.end());
+        auto i = static_cast<std::size_t>(p * static_cast<double>(v.size()));
+        return v[std::min(i, v.size() - 1)];
+    }
+
+    //---- Cold runs ----------------------------------------------------------
+
+    //  In the child: runs one operation once and reports the sample.
+    auto ColdChild(int opIndex, SeedSource::Flags flags) -> int {
+        auto s = kOperations[opIndex].run(flags);
+        std::printf(
+            "%lld %llu %llu %llu %llu\n", static_cast<long long>(s.ns),
+            static_cast<unsigned long long>(s.counts.allocs),
+            static_cast<unsigned long long>(s.counts.getrandom),
+            static_cast<unsigned long long>(s.counts.opens),
+            static_cast<unsigned long long>(s.counts.reads)
+            );
+        return 0;
+    }
+
+    //  In the parent: re-executes this program to run the operation as the
+    //  first thing a process does, returning the median time, or -1 if
+    //  that is not possible on this platform.
+    auto Cold(int opIndex, SeedSource::Flags flags) -> std::int64_t {
+     #if RANDOM_UTIL_HAS_POSIX
+        int runs = gOptions.quick ? 3 : 9;
+        std::vector<std::int64_t> times;
+        for(int r = 0; r < runs; ++r) {
+            int fds[2];
+            if(pipe(fds) != 0) { return -1; }
+            auto op = std::to_string(opIndex);
+            auto fl = std::to_string(flags);
+            pid_t pid = fork();
+            if(pid == 0) {
+                dup2(fds[1], STDOUT_FILENO);
+                close(fds[0]);
+                close(fds[1]);
+                execl(
+                    gOptions.self.c_str(), gOptions.self.c_str(), "--cold",
+                    op.c_str(), fl.c_str(), static_cast<char*>(nullptr)
+                    );
+                _exit(127);
+            }
+            close(fds[1]);
+            char buf[256] = {};
+            std::size_t len = 0;
+            for(ssize_t k; len + 1 < sizeof buf &&
+                (k = ::read(fds[0], buf + len, sizeof buf - 1 - len)) > 0;)
+            {
+                len += static_cast<std::size_t>(k);
+            }
+            close(fds[0]);
+            int status = 0;
+            if(pid < 0 || waitpid(pid, &status, 0) != pid ||
+                !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                return -1;
+            }
+            times.push_back(std::strtoll(buf, nullptr, 10));
+        }
+        return Percentile(times, 0.5);
+     #else
+        return -1;
+     #endif
+    }
+
+    //---- Warm runs ----------------------------------------------------------
+
+    struct Warm {
+        std::int64_t p50, p99;
+        double callsPerSecond;
+        Counts counts;  // summed over all samples of all threads
+        std::size_t samples;
+    };
+
+    auto RunWarm(
+        const Operation& op, SeedSource::Flags flags, unsigned threads
+        ) -> Warm
+    {
+        std::size_t perThread = gOptions.quick ? 200 : 2000;
+        std::vector<std::vector<std::int64_t>> times(threads);
+        std::vector<Counts> counts(threads);
+        std::atomic<unsigned> ready{0};
+        auto worker = [&](unsigned t) {
+            op.run(flags);  // warm up this thread
+            ready.fetch_add(1);
+            while(ready.load() < threads) { std::this_thread::yield(); }
+            times[t].reserve(perThread);
+            for(std::size_t i = 0; i < perThread; ++i) {
+                auto s = op.run(flags);
+                times[t].push_back(s.ns);
+                counts[t].allocs += s.counts.allocs;
+                counts[t].getrandom += s.counts.getrandom;
+                counts[t].opens += s.counts.opens;
+                counts[t].reads += s.counts.reads;
+            }
+        };
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for(unsigned t = 1; t < threads; ++t) { pool.emplace_back(worker, t); }
+        worker(0);
+        for(auto& th: pool) { th.join(); }
+        auto t1 = std::chrono::steady_clock::now();
+
+        Warm w{};
+        std::vector<std::int64_t> all;
+        for(unsigned t = 0; t < threads; ++t) {
+            all.insert(all.end(), times[t].begin(), times[t].end());
+            w.counts.allocs += counts[t].allocs;
+            w.counts.getrandom += counts[t].getrandom;
+            w.counts.opens += counts[t].opens;
+            w.counts.reads += counts[t].reads;
+        }
+        w.samples = all.size();
+        w.callsPerSecond = static_cast<double>(all.size()) /
+            std::chrono::duration<double>(t1 - t0).count();
+        w.p50 = Percentile(all, 0.5);
+        w.p99 = Percentile(all, 0.99);
+        return w;
+    }
+
+    template<typename Fn>
+        void ForEachCase(Fn&& fn) {
+            for(int i = 0; i < static_cast<int>(std::size(kOperations)); ++i) {
+                auto& op = kOperations[i];
+                if(!Selected(op)) { continue; }
+                if(!op.takesFlags) {
+                    fn(i, op, SeedSource::kAll);
+                    continue;
+                }
+                for(SeedSource::Flags f = 0; f <= SeedSource::kAll; ++f) {
+                    fn(i, op, f);
+                }
+            }
+        }
+
+    auto Label(const Operation& op, SeedSource::Flags f) -> std::string {
+        return op.takesFlags ? FlagsLabel(f) : "-";
+    }
+
+    void SingleThreaded() {
+        std::printf(
+            "\nsingle thread (ns)\n%-29s %-14s %9s %8s %8s %7s %9s %5s %5s\n",
+            "operation", "sources", "cold", "p50", "p99", "allocs",
+            "getrandom", "open", "read"
+            );
+        ForEachCase([](int i, const Operation& op, SeedSource::Flags f) {
+            auto cold = Cold(i, f);
+            auto w = RunWarm(op, f, 1);
+            auto per = [&](std::uint64_t n) {
+                return static_cast<double>(n) /
+                    static_cast<double>(w.samples);
+            };
+            char coldText[32] = "-";
+            if(cold >= 0) {
+                std::snprintf(
+                    coldText, sizeof coldText, "%lld",
+                    static_cast<long long>(cold)
+                    );
+            }
+            std::printf(
+                "%-29s %-14s %9s %8lld %8lld %7.1f %9.1f %5.1f %5.1f\n",
+                op.name, Label(op, f).c_str(), coldText,
+                static_cast<long long>(w.p50), static_cast<long long>(w.p99),
+                per(w.counts.allocs), per(w.counts.getrandom),
+                per(w.counts.opens), per(w.counts.reads)
+                );
+        });
+    }
+
+    void MultiThreaded() {
+        auto threads = gOptions.threads;
+        std::printf(
+            "\n%u threads at once (ns)\n%-29s %-14s %10s %8s %8s\n",
+            threads, "operation", "sources", "kcalls/s", "p50", "p99"
+            );
+        ForEachCase([&](int, const Operation& op, SeedSource::Flags f) {
+            auto w = RunWarm(op, f, threads);
+            std::printf(
+                "%-29s %-14s %10.1f %8lld %8lld\n", op.name,
+                Label(op, f).c_str(), w.callsPerSecond * 1e-3,
+                static_cast<long long>(w.p50), static_cast<long long>(w.p99)
+                );
+        });
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc == 4 && std::strcmp(argv[1], "--cold") == 0) {
+        return ColdChild(
+            std::atoi(argv[2]),
+            static_cast<SeedSource::Flags>(std::strtoul(argv[3], nullptr, 10))
+            );
+    }
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--quick") == 0) {
+            gOptions.quick = true;
+        }
+        else if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            gOptions.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        }
+        else if(std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            gOptions.filter = argv[++i];
+        }
+        else {
+            std::fprintf(
+                stderr, "usage: %s [--quick] [--threads N] [--filter TEXT]\n",
+                argv[0]
+                );
+            return 2;
+        }
+    }
+    if(gOptions.threads == 0) {
+        gOptions.threads = std::max(2u, std::thread::hardware_concurrency());
+    }
+ #if RANDOM_UTIL_HAS_POSIX && defined(__linux__)
+    gOptions.self = "/proc/self/exe";
+ #else
+    gOptions.self = argv[0];
+ #endif
+    std::printf(
+        "random_util seeding benchmarks (%u hardware threads, libc call "
+        "counts %s)\n", std::thread::hardware_concurrency(),
+        BENCH_INTERPOSE ? "interposed" : "unavailable"
+        );
+    SingleThreaded();
+    MultiThreaded();
+    return 0;
+}
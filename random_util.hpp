@@ -1,13 +1,97 @@
 #ifndef RANDOM_UTIL_HPP
 #define RANDOM_UTIL_HPP
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+ #define RANDOM_UTIL_HAS_POSIX 1
+ #include <fcntl.h>
+ #include <pthread.h>
+ #include <sys/file.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#else
+ #define RANDOM_UTIL_HAS_POSIX 0
+#endif
+
+#if defined(__linux__)
+ #include <sched.h>
+ #include <sys/syscall.h>
+ #if defined(__GLIBC__) && defined(__has_include) && defined(__has_builtin)
+  #if __has_include(<sys/rseq.h>) && __has_builtin(__builtin_thread_pointer)
+   #include <sys/rseq.h>
+  #endif
+ #endif
+#endif
+#if defined(RSEQ_SIG)
+ #define RANDOM_UTIL_HAS_RSEQ 1
+#else
+ #define RANDOM_UTIL_HAS_RSEQ 0
+#endif
+
+//  <execution> can bring in a link dependency (libstdc++ with TBB headers
+//  installed wants -ltbb), so the execution policy overloads are only
+//  compiled if it was included before this header or if
+//  RANDOM_UTIL_USE_EXECUTION is defined.
+#if defined(__cpp_lib_execution) || defined(RANDOM_UTIL_USE_EXECUTION)
+ #if defined(__has_include)
+  #if __has_include(<execution>)
+   #include <execution>
+  #endif
+ #endif
+#endif
+#if defined(__cpp_lib_execution)
+ #define RANDOM_UTIL_HAS_EXECUTION 1
+#else
+ #define RANDOM_UTIL_HAS_EXECUTION 0
+#endif
+
+#if defined(__has_include) && __cplusplus >= 202002L
+ #if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+  #include <coroutine>
+ #endif
+ #if __has_include(<ranges>)
+  #include <ranges>
+ #endif
+#endif
+#if defined(__cpp_lib_coroutine)
+ #define RANDOM_UTIL_HAS_COROUTINES 1
+#else
+ #define RANDOM_UTIL_HAS_COROUTINES 0
+#endif
+#if defined(__cpp_lib_ranges)
+ #define RANDOM_UTIL_HAS_RANGES 1
+#else
+ #define RANDOM_UTIL_HAS_RANGES 0
+#endif
 
 /*---- SeedSource -------------------------------------------------------------
  *
@@ -327,4 +411,5301 @@ inline auto MakeMTEngine(SeedSource::Flags flags = SeedSource::kAll)
         return MTEngineT(seq);
     }
 
+/*---- RandomUtilDetail -------------------------------------------------------
+ *
+ *  RandomUtilDetail is a namespace of implementation helpers shared by the
+ *  sections that follow. None of it is intended to be called directly by
+ *  client code, and it may change without notice.
+ */
+
+namespace RandomUtilDetail {
+
+    //  Draws N 64-bit words of key material from a SeedSequence such as
+    //  SeedSource::Seq, pairing up the 32-bit words it generates.
+    template<std::size_t N, typename SeedSeq>
+        auto SeedWords(SeedSeq& seq) -> std::array<std::uint64_t,N> {
+            std::array<std::uint_least32_t,2 * N> raw;
+            seq.generate(raw.begin(), raw.end());
+            std::array<std::uint64_t,N> words;
+            for(std::size_t i = 0; i < N; ++i) {
+                words[i] = std::uint64_t{raw[2 * i] & 0xffffffffu} << 32 |
+                    (raw[2 * i + 1] & 0xffffffffu);
+            }
+            return words;
+        }
+
+    //  The SplitMix64 finalizer: a cheap bijective mixing function that
+    //  turns structured input (counters, indices) into well-scattered bits.
+    inline constexpr auto Mix64(std::uint64_t x) noexcept -> std::uint64_t {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9u;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebu;
+        x ^= x >> 31;
+        return x;
+    }
+
+    //  Returns the high 64 bits of the 128-bit product a * b and writes the
+    //  low 64 bits to lo.
+    inline auto MulHiLo64(std::uint64_t a, std::uint64_t b, std::uint64_t& lo)
+        noexcept -> std::uint64_t
+    {
+     #if defined(__SIZEOF_INT128__)
+        __extension__ using U128 = unsigned __int128;
+        U128 p = static_cast<U128>(a) * b;
+        lo = static_cast<std::uint64_t>(p);
+        return static_cast<std::uint64_t>(p >> 64);
+     #else
+        std::uint64_t aLo = a & 0xffffffffu, aHi = a >> 32;
+        std::uint64_t bLo = b & 0xffffffffu, bHi = b >> 32;
+        std::uint64_t ll = aLo * bLo, lh = aLo * bHi;
+        std::uint64_t hl = aHi * bLo, hh = aHi * bHi;
+        std::uint64_t mid = (ll >> 32) + (lh & 0xffffffffu) +
+            (hl & 0xffffffffu);
+        lo = (mid << 32) | (ll & 0xffffffffu);
+        return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+     #endif
+    }
+
+    inline auto CountTrailingZeros(std::uint64_t x) noexcept -> unsigned {
+     #if defined(__GNUC__)
+        return x ? static_cast<unsigned>(__builtin_ctzll(x)) : 64u;
+     #else
+        unsigned n = 0;
+        for(; n < 64u && !(x & 1u); ++n) { x >>= 1; }
+        return n;
+     #endif
+    }
+
+    inline constexpr auto ReverseBits32(std::uint32_t x) noexcept
+        -> std::uint32_t
+    {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00ff00ffu) << 8) | ((x >> 8) & 0x00ff00ffu);
+        x = ((x & 0x0f0f0f0fu) << 4) | ((x >> 4) & 0x0f0f0f0fu);
+        x = ((x & 0x33333333u) << 2) | ((x >> 2) & 0x33333333u);
+        x = ((x & 0x55555555u) << 1) | ((x >> 1) & 0x55555555u);
+        return x;
+    }
+
+    //  Hash-based nested uniform (Owen) scrambling of a 32-bit binary
+    //  fraction as described by Burley, "Practical Hash-based Owen
+    //  Scrambling" (JCGT 2020). The Laine-Karras permutation only lets
+    //  higher bits affect lower ones, so it is applied to the bit-reversed
+    //  value.
+    inline constexpr auto OwenScramble32(std::uint32_t x, std::uint32_t seed)
+        noexcept -> std::uint32_t
+    {
+        x = ReverseBits32(x);
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return ReverseBits32(x);
+    }
+
+    //  Maps 64 random bits onto a double in [0.0,1.0) using the top 53.
+    inline constexpr auto ToUnit(std::uint64_t bits) noexcept -> double {
+        return static_cast<double>(bits >> 11) * 0x1p-53;
+    }
+
+    //  Returns 64 uniformly random bits from any UniformRandomBitGenerator,
+    //  calling it only once when it already produces full 64-bit words and
+    //  twice for full 32-bit words such as std::mt19937.
+    template<typename URBG>
+        auto Bits64(URBG& g) -> std::uint64_t {
+            constexpr auto kMin = static_cast<std::uint64_t>(URBG::min());
+            constexpr auto kMax = static_cast<std::uint64_t>(URBG::max());
+            if constexpr(kMin == 0u && kMax == 0xffffffffffffffffu) {
+                return static_cast<std::uint64_t>(g());
+            }
+            else if constexpr(kMin == 0u && kMax == 0xffffffffu) {
+                auto hi = static_cast<std::uint64_t>(g());
+                return hi << 32 | static_cast<std::uint64_t>(g());
+            }
+            else {
+                return std::uniform_int_distribution<std::uint64_t>{}(g);
+            }
+        }
+
+    //  Returns an unbiased integer in [0,n) for n > 0 using Lemire's
+    //  nearly divisionless multiply-and-reject method ("Fast Random Integer
+    //  Generation in an Interval", 2019).
+    template<typename URBG>
+        auto Bounded(URBG& g, std::uint64_t n) -> std::uint64_t {
+            std::uint64_t lo;
+            auto hi = MulHiLo64(Bits64(g), n, lo);
+            if(lo < n) {
+                std::uint64_t threshold = (0u - n) % n;
+                while(lo < threshold) {
+                    hi = MulHiLo64(Bits64(g), n, lo);
+                }
+            }
+            return hi;
+        }
+
+    inline constexpr double kTwoPi = 6.283185307179586476925286766559;
+
+    //  Fills out[0,n) with standard normal deviates by the Box-Muller
+    //  transform. Uniforms are drawn a block at a time so that the transform
+    //  loop makes no engine calls, leaving it free to be auto-vectorized
+    //  where the compiler has a vector math library to call on.
+    template<typename URBG, typename Real>
+        void FillStandardNormal(URBG& g, Real* out, std::size_t n) {
+            constexpr std::size_t kBlock = 128;
+            std::array<double,kBlock> u, v;
+            while(n > 0) {
+                auto m = std::min(kBlock, (n + 1) / 2);
+                for(std::size_t i = 0; i < m; ++i) {
+                    u[i] = 1.0 - ToUnit(Bits64(g));
+                    v[i] = ToUnit(Bits64(g));
+                }
+                for(std::size_t i = 0; i < m; ++i) {
+                    u[i] = std::sqrt(-2.0 * std::log(u[i]));
+                    v[i] *= kTwoPi;
+                }
+                for(std::size_t i = 0; i < m; ++i) {
+                    out[i] = static_cast<Real>(u[i] * std::cos(v[i]));
+                }
+                auto k = std::min(m, n - m);
+                for(std::size_t i = 0; i < k; ++i) {
+                    out[m + i] = static_cast<Real>(u[i] * std::sin(v[i]));
+                }
+                out += m + k;
+                n -= m + k;
+            }
+        }
+
+    //  Fills out[0,n) with standard exponential deviates by inversion.
+    template<typename URBG, typename Real>
+        void FillStandardExponential(URBG& g, Real* out, std::size_t n) {
+            for(std::size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<Real>(1.0 - ToUnit(Bits64(g)));
+            }
+            for(std::size_t i = 0; i < n; ++i) {
+                out[i] = static_cast<Real>(-std::log(out[i]));
+            }
+        }
+
+    //  Hex-encodes 4 bytes into 8 lowercase ASCII characters at once using
+    //  SIMD-within-a-register arithmetic on a 64-bit word: the bytes are
+    //  spread out to one nibble per byte lane, and each lane is then offset
+    //  to '0'-'9' or 'a'-'f' without branching.
+    inline void HexEncode4(const std::byte* in, char* out) noexcept {
+        std::uint64_t x = std::to_integer<std::uint64_t>(in[0]) |
+            std::to_integer<std::uint64_t>(in[1]) << 8 |
+            std::to_integer<std::uint64_t>(in[2]) << 16 |
+            std::to_integer<std::uint64_t>(in[3]) << 24;
+        x = (x | x << 16) & 0x0000ffff0000ffffu;
+        x = (x | x << 8) & 0x00ff00ff00ff00ffu;
+        x = ((x >> 4) & 0x0f0f0f0f0f0f0f0fu) | (x & 0x0f0f0f0f0f0f0f0fu) << 8;
+        auto letters = ((x + 0x0606060606060606u) >> 4) & 0x0101010101010101u;
+        x += 0x3030303030303030u + letters * ('a' - '0' - 10);
+        for(unsigned k = 0; k < 8u; ++k) {
+            out[k] = static_cast<char>(x >> 8 * k);
+        }
+    }
+
+    //  Primitive polynomials and initial direction numbers for Sobol
+    //  dimensions 2 through 64, taken from S. Joe and F. Y. Kuo's
+    //  new-joe-kuo-6.21201 table ("Constructing Sobol sequences with better
+    //  two-dimensional projections", SIAM J. Sci. Comput. 30, 2008).
+    //  Each polynomial is stored with both its leading and constant terms,
+    //  so its degree is the position of its highest set bit.
+    struct SobolPolynomial {
+        std::uint_least16_t poly;
+        std::uint_least16_t m[9];
+    };
+    inline constexpr SobolPolynomial kSobolPolynomials[] = {
+        {  3, {1}},
+        {  7, {1, 3}},
+        { 11, {1, 3, 1}},
+        { 13, {1, 1, 1}},
+        { 19, {1, 1, 3, 3}},
+        { 25, {1, 3, 5, 13}},
+        { 37, {1, 1, 5, 5, 17}},
+        { 41, {1, 1, 5, 5, 5}},
+        { 47, {1, 1, 7, 11, 19}},
+        { 55, {1, 1, 5, 1, 1}},
+        { 59, {1, 1, 1, 3, 11}},
+        { 61, {1, 3, 5, 5, 31}},
+        { 67, {1, 3, 3, 9, 7, 49}},
+        { 91, {1, 1, 1, 15, 21, 21}},
+        { 97, {1, 3, 1, 13, 27, 49}},
+        {103, {1, 1, 1, 15, 7, 5}},
+        {109, {1, 3, 1, 15, 13, 25}},
+        {115, {1, 1, 5, 5, 19, 61}},
+        {131, {1, 3, 7, 11, 23, 15, 103}},
+        {137, {1, 3, 7, 13, 13, 15, 69}},
+        {143, {1, 1, 3, 13, 7, 35, 63}},
+        {145, {1, 3, 5, 9, 1, 25, 53}},
+        {157, {1, 3, 1, 13, 9, 35, 107}},
+        {167, {1, 3, 1, 5, 27, 61, 31}},
+        {171, {1, 1, 5, 11, 19, 41, 61}},
+        {185, {1, 3, 5, 3, 3, 13, 69}},
+        {191, {1, 1, 7, 13, 1, 19, 1}},
+        {193, {1, 3, 7, 5, 13, 19, 59}},
+        {203, {1, 1, 3, 9, 25, 29, 41}},
+        {211, {1, 3, 5, 13, 23, 1, 55}},
+        {213, {1, 3, 7, 3, 13, 59, 17}},
+        {229, {1, 3, 1, 3, 5, 53, 69}},
+        {239, {1, 1, 5, 5, 23, 33, 13}},
+        {241, {1, 1, 7, 7, 1, 61, 123}},
+        {247, {1, 1, 7, 9, 13, 61, 49}},
+        {253, {1, 3, 3, 5, 3, 55, 33}},
+        {285, {1, 3, 1, 15, 31, 13, 49, 245}},
+        {299, {1, 3, 5, 15, 31, 59, 63, 97}},
+        {301, {1, 3, 1, 11, 11, 11, 77, 249}},
+        {333, {1, 3, 1, 11, 27, 43, 71, 9}},
+        {351, {1, 1, 7, 15, 21, 11, 81, 45}},
+        {355, {1, 3, 7, 3, 25, 31, 65, 79}},
+        {357, {1, 3, 1, 1, 19, 11, 3, 205}},
+        {361, {1, 1, 5, 9, 19, 21, 29, 157}},
+        {369, {1, 3, 7, 11, 1, 33, 89, 185}},
+        {391, {1, 3, 3, 3, 15, 9, 79, 71}},
+        {397, {1, 3, 7, 11, 15, 39, 119, 27}},
+        {425, {1, 1, 3, 1, 11, 31, 97, 225}},
+        {451, {1, 1, 1, 3, 23, 43, 57, 177}},
+        {463, {1, 3, 7, 7, 17, 17, 37, 71}},
+        {487, {1, 3, 1, 5, 27, 63, 123, 213}},
+        {501, {1, 1, 3, 5, 11, 43, 53, 133}},
+        {529, {1, 3, 5, 5, 29, 17, 47, 173, 479}},
+        {539, {1, 3, 3, 11, 3, 1, 109, 9, 69}},
+        {545, {1, 1, 1, 5, 17, 39, 23, 5, 343}},
+        {557, {1, 3, 1, 5, 25, 15, 31, 103, 499}},
+        {563, {1, 1, 1, 11, 11, 17, 63, 105, 183}},
+        {601, {1, 1, 5, 11, 9, 29, 97, 231, 363}},
+        {607, {1, 1, 5, 15, 19, 45, 41, 7, 383}},
+        {617, {1, 3, 7, 7, 31, 19, 83, 137, 221}},
+        {623, {1, 1, 1, 3, 23, 15, 111, 223, 83}},
+        {631, {1, 1, 5, 13, 31, 15, 55, 25, 161}},
+        {637, {1, 1, 3, 13, 25, 47, 39, 87, 257}},
+    };
+}
+
+/*---- QuasiRandom ------------------------------------------------------------
+ *
+ *  QuasiRandom is a namespace of low-discrepancy sequence generators for
+ *  quasi-Monte Carlo work. Where a pseudo-random engine's integration error
+ *  shrinks like O(N^-1/2), these fill the unit hypercube [0,1)^d far more
+ *  evenly and typically converge close to O(N^-1) for smooth integrands.
+ *
+ *  Three generators are provided:
+ *
+ *      Sobol:
+ *          A base-2 digital sequence built from Joe-Kuo direction numbers
+ *          (up to Sobol::kMaxDims dimensions and Sobol::kMaxPoints = 2^32
+ *          points). Points are enumerated in Gray code order, so each
+ *          successive point costs a single XOR per dimension and point i
+ *          can be computed directly. Since the sequence would start over
+ *          past its last point, asking for point i >= kMaxPoints (through
+ *          point, next, generate or seek) throws std::length_error.
+ *
+ *      Halton:
+ *          Radical inverses of the point index in the first d prime bases.
+ *          Simple and extensible, but its quality degrades in higher
+ *          dimensions (roughly beyond a few dozen) unless it is scrambled.
+ *
+ *      RSequence:
+ *          Roberts' R_d additive recurrence, x_i = frac(s + i * alpha), with
+ *          alpha derived from the generalized golden ratio. It has no upper
+ *          limit on dimension and is the cheapest of the three per point.
+ *
+ *  All three share the same interface. Points are written as d consecutive
+ *  doubles in [0.0,1.0) through a random-access iterator.
+ *
+ *      point(i, it):
+ *          Writes point i without disturbing the sequential position.
+ *      next(it):
+ *          Writes the point at the current position and advances it.
+ *      generate(bgnIt, endIt):
+ *          Fills the range with successive points in row-major order (point
+ *          after point). Any trailing elements too few to hold a whole point
+ *          are left untouched.
+ *      seek(i), index():
+ *          Set/get the sequential position.
+ *      dims():
+ *          Returns the dimension count.
+ *
+ *  Scrambling:
+ *      A raw low-discrepancy sequence is deterministic, so it offers no
+ *      error estimate. Scrambling randomizes it while preserving its
+ *      equidistribution, letting you average independent replicates. It is
+ *      selected by one of the following flags, and its randomness is drawn
+ *      from a SeedSequence passed to the constructor (a default-constructed
+ *      SeedSource::Seq unless you supply one).
+ *
+ *      kNoScrambling:
+ *          The plain sequence. No seed data is consumed.
+ *      kDigitalShift:
+ *          Sobol: XORs a random 32-bit word into each dimension.
+ *          Halton: adds a random digit modulo the base at every digit place.
+ *          RSequence: applies a random toroidal (Cranley-Patterson) shift.
+ *      kOwenScrambling:
+ *          Sobol: hash-based nested uniform scrambling (Burley 2020).
+ *          Halton: an independent random permutation of the digits at each
+ *          digit place (not fully nested, but much cheaper in memory).
+ *          RSequence: as kDigitalShift, since it is a lattice rather than a
+ *          digital net.
+ *
+ *  Example:
+ *
+ *      QuasiRandom::Sobol sobol{2, QuasiRandom::kOwenScrambling};
+ *      std::vector<double> pts(2 * 1024);
+ *      sobol.generate(pts.begin(), pts.end());
+ *      double inside = 0.0;
+ *      for(std::size_t i = 0; i < pts.size(); i += 2) {
+ *          inside += pts[i] * pts[i] + pts[i + 1] * pts[i + 1] < 1.0;
+ *      }
+ *      std::cout << 4.0 * inside / 1024 << '\n';  // close to pi
+ */
+
+namespace QuasiRandom {
+
+    using Scrambling = std::uint_least32_t;
+
+    inline constexpr Scrambling kNoScrambling   = 0x00000000;
+    inline constexpr Scrambling kDigitalShift   = 0x00000001;
+    inline constexpr Scrambling kOwenScrambling = 0x00000002;
+
+    //---- Sobol --------------------------------------------------------------
+
+    class Sobol {
+    public:
+        static constexpr std::size_t kMaxDims = 1 + std::size(
+            RandomUtilDetail::kSobolPolynomials
+            );
+        static constexpr unsigned kBits = 32;
+        static constexpr std::uint64_t kMaxPoints = std::uint64_t{1} << kBits;
+
+        template<typename SeedSeq = SeedSource::Seq>
+            explicit Sobol(
+                std::size_t dims, Scrambling scrambling = kNoScrambling,
+                SeedSeq&& seq = SeedSeq{}
+                ):
+                dimCount{dims},
+                scrambling{scrambling},
+                dirs(kBits * dims),
+                state(dims),
+                seeds(dims)
+            {
+                if(dims == 0 || dims > kMaxDims) {
+                    throw std::invalid_argument{
+                        "QuasiRandom::Sobol: dims must be in [1,kMaxDims]"
+                        };
+                }
+                this->initDirections();
+                if(scrambling != kNoScrambling) {
+                    std::mt19937 g{seq};
+                    for(auto& seed: this->seeds) {
+                        seed = static_cast<std::uint32_t>(g());
+                    }
+                }
+            }
+
+        auto dims() const noexcept -> std::size_t { return this->dimCount; }
+        auto index() const noexcept -> std::uint64_t { return this->pos; }
+
+        void seek(std::uint64_t i) {
+            if(i > kMaxPoints) { ThrowExhausted(); }
+            this->pos = i;
+            this->raw(i, this->state.begin());
+        }
+
+        template<typename RandomIt>
+            void point(std::uint64_t i, RandomIt it) const {
+                if(i >= kMaxPoints) { ThrowExhausted(); }
+                std::array<std::uint32_t,kMaxDims> x;
+                this->raw(i, x.begin());
+                for(std::size_t j = 0; j < this->dimCount; ++j) {
+                    it[j] = this->toReal(j, x[j]);
+                }
+            }
+
+        template<typename RandomIt>
+            void next(RandomIt it) {
+                if(this->pos >= kMaxPoints) { ThrowExhausted(); }
+                auto n = this->dimCount;
+                for(std::size_t j = 0; j < n; ++j) {
+                    it[j] = this->toReal(j, this->state[j]);
+                }
+
+                //  Moving from Gray code g(i) to g(i + 1) flips exactly one
+                //  bit: the lowest set bit of i + 1.
+                auto c = RandomUtilDetail::CountTrailingZeros(++this->pos);
+                if(c >= kBits) { return; }  // past the last point
+                const std::uint32_t* v = &this->dirs[c * n];
+                for(std::size_t j = 0; j < n; ++j) {
+                    this->state[j] ^= v[j];
+                }
+            }
+
+        template<typename RandomIt>
+            void generate(RandomIt bgnIt, RandomIt endIt) {
+                auto n = static_cast<std::ptrdiff_t>(this->dimCount);
+                auto points = static_cast<std::uint64_t>((endIt - bgnIt) / n);
+                if(points > kMaxPoints - this->pos) { ThrowExhausted(); }
+                for(; endIt - bgnIt >= n; bgnIt += n) {
+                    this->next(bgnIt);
+                }
+            }
+
+    private:
+        std::size_t dimCount;
+        Scrambling scrambling;
+        std::uint64_t pos = 0;
+
+        //  Direction numbers are stored bit-major (dirs[k * dims + j]) so
+        //  that a Gray code step XORs one contiguous row into the state.
+        std::vector<std::uint32_t> dirs;
+        std::vector<std::uint32_t> state;
+        std::vector<std::uint32_t> seeds;
+
+        [[noreturn]] static void ThrowExhausted() {
+            throw std::length_error{
+                "QuasiRandom::Sobol: index beyond kMaxPoints"
+                };
+        }
+
+        void initDirections() {
+            auto n = this->dimCount;
+            for(unsigned k = 0; k < kBits; ++k) {
+                this->dirs[k * n] = std::uint32_t{1} << (kBits - 1 - k);
+            }
+            for(std::size_t j = 1; j < n; ++j) {
+                const auto& p = RandomUtilDetail::kSobolPolynomials[j - 1];
+                unsigned s = 0;
+                for(auto q = p.poly; q > 1u; q >>= 1) { ++s; }
+
+                //  m[k] holds the odd direction integer m_{k+1} < 2^(k+1).
+                //  Beyond the tabulated initial values, it follows the
+                //  recurrence defined by the polynomial's coefficients.
+                std::array<std::uint32_t,kBits> m;
+                for(unsigned k = 0; k < kBits; ++k) {
+                    if(k < s) {
+                        m[k] = p.m[k];
+                        continue;
+                    }
+                    m[k] = m[k - s] ^ (m[k - s] << s);
+                    for(unsigned i = 1; i < s; ++i) {
+                        if((p.poly >> (s - i)) & 1u) {
+                            m[k] ^= m[k - i] << i;
+                        }
+                    }
+                }
+                for(unsigned k = 0; k < kBits; ++k) {
+                    this->dirs[k * n + j] = m[k] << (kBits - 1 - k);
+                }
+            }
+        }
+
+        template<typename It>
+            void raw(std::uint64_t i, It out) const {
+                auto n = this->dimCount;
+                for(std::size_t j = 0; j < n; ++j) { out[j] = 0; }
+                auto gray = i ^ (i >> 1);
+                for(unsigned k = 0; gray && k < kBits; ++k, gray >>= 1) {
+                    if(gray & 1u) {
+                        const std::uint32_t* v = &this->dirs[k * n];
+                        for(std::size_t j = 0; j < n; ++j) { out[j] ^= v[j]; }
+                    }
+                }
+            }
+
+        auto toReal(std::size_t j, std::uint32_t x) const -> double {
+            if(this->scrambling == kDigitalShift) {
+                x ^= this->seeds[j];
+            }
+            else if(this->scrambling == kOwenScrambling) {
+                x = RandomUtilDetail::OwenScramble32(x, this->seeds[j]);
+            }
+            return static_cast<double>(x) * 0x1p-32;
+        }
+    };
+
+    //---- Halton -------------------------------------------------------------
+
+    class Halton {
+    public:
+        static constexpr std::size_t kMaxDims = 256;
+
+        template<typename SeedSeq = SeedSource::Seq>
+            explicit Halton(
+                std::size_t dims, Scrambling scrambling = kNoScrambling,
+                SeedSeq&& seq = SeedSeq{}
+                ):
+                dimCount{dims},
+                scrambling{scrambling}
+            {
+                if(dims == 0 || dims > kMaxDims) {
+                    throw std::invalid_argument{
+                        "QuasiRandom::Halton: dims must be in [1,kMaxDims]"
+                        };
+                }
+                for(std::uint32_t c = 2; this->bases.size() < dims; ++c) {
+                    bool prime = true;
+                    for(auto b: this->bases) {
+                        if(b * b > c) { break; }
+                        if(c % b == 0) { prime = false; break; }
+                    }
+                    if(prime) { this->bases.push_back(c); }
+                }
+                if(scrambling != kNoScrambling) {
+                    this->initTables(seq);
+                }
+            }
+
+        auto dims() const noexcept -> std::size_t { return this->dimCount; }
+        auto index() const noexcept -> std::uint64_t { return this->pos; }
+        void seek(std::uint64_t i) noexcept { this->pos = i; }
+
+        template<typename RandomIt>
+            void point(std::uint64_t i, RandomIt it) const {
+                for(std::size_t j = 0; j < this->dimCount; ++j) {
+                    it[j] = this->radicalInverse(j, i);
+                }
+            }
+
+        template<typename RandomIt>
+            void next(RandomIt it) { this->point(this->pos++, it); }
+
+        template<typename RandomIt>
+            void generate(RandomIt bgnIt, RandomIt endIt) {
+                auto n = static_cast<std::ptrdiff_t>(this->dimCount);
+                for(; endIt - bgnIt >= n; bgnIt += n) {
+                    this->next(bgnIt);
+                }
+            }
+
+    private:
+        std::size_t dimCount;
+        Scrambling scrambling;
+        std::uint64_t pos = 0;
+        std::vector<std::uint32_t> bases;
+
+        //  For scrambled sequences, every dimension j processes a fixed
+        //  number of digit places (enough to resolve 2^-53) so that the
+        //  leading zero digits of small indices get scrambled too. The
+        //  per-place shifts or permutations live in one flat table.
+        std::vector<unsigned> digitPlaces;
+        std::vector<std::size_t> tableOffsets;
+        std::vector<std::uint32_t> table;
+
+        template<typename SeedSeq>
+            void initTables(SeedSeq& seq) {
+                std::mt19937_64 g{seq};
+                for(auto b: this->bases) {
+                    unsigned places = 0;
+                    for(double r = 1.0; r > 0x1p-53; r /= b) { ++places; }
+                    this->digitPlaces.push_back(places);
+                    this->tableOffsets.push_back(this->table.size());
+                    for(unsigned k = 0; k < places; ++k) {
+                        if(this->scrambling == kDigitalShift) {
+                            this->table.push_back(
+                                static_cast<std::uint32_t>(
+                                    RandomUtilDetail::Bounded(g, b)
+                                    )
+                                );
+                            continue;
+                        }
+                        auto first = this->table.size();
+                        for(std::uint32_t d = 0; d < b; ++d) {
+                            this->table.push_back(d);
+                        }
+                        for(std::uint32_t d = b - 1; d > 0; --d) {
+                            auto e = RandomUtilDetail::Bounded(g, d + 1);
+                            std::swap(
+                                this->table[first + d], this->table[first + e]
+                                );
+                        }
+                    }
+                }
+            }
+
+        auto radicalInverse(std::size_t j, std::uint64_t i) const -> double {
+            std::uint64_t b = this->bases[j];
+            double inv = 1.0 / static_cast<double>(b);
+            double f = inv, r = 0.0;
+            if(this->scrambling == kNoScrambling) {
+                for(; i; i /= b, f *= inv) {
+                    r += static_cast<double>(i % b) * f;
+                }
+                return r;
+            }
+            const std::uint32_t* t = &this->table[this->tableOffsets[j]];
+            for(unsigned k = 0; k < this->digitPlaces[j]; ++k, f *= inv) {
+                auto d = i % b;
+                i /= b;
+                d = this->scrambling == kDigitalShift ?
+                    (d + t[k]) % b : t[k * b + d];
+                r += static_cast<double>(d) * f;
+            }
+
+            //  Rounding in the accumulation can occasionally land exactly
+            //  on 1.0 when every scrambled digit is b - 1.
+            return r < 1.0 ? r : 1.0 - 0x1p-53;
+        }
+    };
+
+    //---- RSequence ----------------------------------------------------------
+
+    class RSequence {
+    public:
+        template<typename SeedSeq = SeedSource::Seq>
+            explicit RSequence(
+                std::size_t dims, Scrambling scrambling = kNoScrambling,
+                SeedSeq&& seq = SeedSeq{}
+                ):
+                dimCount{dims},
+                alphas(dims),
+                offsets(dims, std::uint64_t{1} << 63)
+            {
+                if(dims == 0) {
+                    throw std::invalid_argument{
+                        "QuasiRandom::RSequence: dims must be positive"
+                        };
+                }
+
+                //  phi_d is the unique positive root of x^(d+1) = x + 1,
+                //  found here by fixed-point iteration. alpha_j is then
+                //  (1/phi_d)^(j+1), kept as a 64-bit binary fraction so
+                //  that i * alpha wraps modulo 1 exactly.
+                long double phi = 2.0L;
+                for(int k = 0; k < 128; ++k) {
+                    phi = std::pow(1.0L + phi, 1.0L / (dims + 1.0L));
+                }
+                long double a = 1.0L;
+                for(std::size_t j = 0; j < dims; ++j) {
+                    a /= phi;
+                    this->alphas[j] = static_cast<std::uint64_t>(
+                        std::ldexp(a, 64)
+                        );
+                }
+                if(scrambling != kNoScrambling) {
+                    std::mt19937_64 g{seq};
+                    for(auto& offset: this->offsets) {
+                        offset = static_cast<std::uint64_t>(g());
+                    }
+                }
+            }
+
+        auto dims() const noexcept -> std::size_t { return this->dimCount; }
+        auto index() const noexcept -> std::uint64_t { return this->pos; }
+        void seek(std::uint64_t i) noexcept { this->pos = i; }
+
+        template<typename RandomIt>
+            void point(std::uint64_t i, RandomIt it) const {
+                for(std::size_t j = 0; j < this->dimCount; ++j) {
+                    it[j] = RandomUtilDetail::ToUnit(
+                        this->offsets[j] + i * this->alphas[j]
+                        );
+                }
+            }
+
+        template<typename RandomIt>
+            void next(RandomIt it) { this->point(this->pos++, it); }
+
+        template<typename RandomIt>
+            void generate(RandomIt bgnIt, RandomIt endIt) {
+                auto n = static_cast<std::ptrdiff_t>(this->dimCount);
+                for(; endIt - bgnIt >= n; bgnIt += n) {
+                    this->next(bgnIt);
+                }
+            }
+
+    private:
+        std::size_t dimCount;
+        std::uint64_t pos = 0;
+        std::vector<std::uint64_t> alphas;
+        std::vector<std::uint64_t> offsets;
+    };
+}
+
+/*---- RandomPermutation ------------------------------------------------------
+ *
+ *  RandomPermutation is a keyed pseudo-random bijection over the integers
+ *  [0,n). It lets you visit a huge index space in shuffled order without
+ *  ever materializing the shuffled array: permute(i) and inverse(j) each
+ *  take O(1) time and the object occupies a few dozen bytes whatever n is.
+ *
+ *  Internally, it is a balanced Feistel network over the smallest domain
+ *  of 2^(2h) integers covering [0,n), using a SplitMix64-style round
+ *  function keyed from a SeedSequence. Outputs that land outside [0,n) are
+ *  fed back through the network ("cycle-walking") until they fall inside.
+ *  Since the domain is less than 4n, this takes under 4 passes on average.
+ *
+ *  The result is a pseudo-random permutation rather than a uniformly drawn
+ *  one: for a given key it is fixed, and no statistical test short of
+ *  recovering the key should tell it apart from a true shuffle. That makes
+ *  it ideal for crawlers and test harnesses, but it is not a cipher.
+ *
+ *  Constructor args:
+ *      n (std::uint64_t): the size of the index space
+ *      seq (SeedSequence, optional): source of the round keys
+ *          Defaults to a default-constructed SeedSource::Seq. Pass a
+ *          std::seed_seq with fixed values to make the order reproducible.
+ *
+ *  Methods:
+ *      size(): returns n
+ *      permute(i): returns the image of index i (i < n)
+ *      inverse(j): returns the index i for which permute(i) == j (j < n)
+ *      permute(first, count, it): writes permute(first + k) for k in
+ *          [0,count) through an output iterator and returns its end
+ *      operator[](i): same as permute(i)
+ *      begin(), end(): random-access iterators over the permuted order
+ *
+ *  Example:
+ *
+ *      RandomPermutation perm{10'000'000'000};
+ *      for(auto id: perm) {
+ *          crawl(id);  // each id in [0,1e10) is visited exactly once
+ *      }
+ */
+
+class RandomPermutation {
+public:
+    static constexpr unsigned kRounds = 4;
+
+    class Iterator;
+
+    template<typename SeedSeq = SeedSource::Seq>
+        explicit RandomPermutation(std::uint64_t n, SeedSeq&& seq = SeedSeq{}):
+            n{n}
+        {
+            unsigned bits = 0;
+            for(auto m = n > 1u ? n - 1u : 0u; m; m >>= 1) { ++bits; }
+            this->halfBits = bits > 1u ? (bits + 1u) / 2u : 1u;
+            this->mask = (std::uint64_t{1} << this->halfBits) - 1u;
+            if(n > 1u) {
+                this->keys = RandomUtilDetail::SeedWords<kRounds>(seq);
+            }
+        }
+
+    auto size() const noexcept -> std::uint64_t { return this->n; }
+
+    auto permute(std::uint64_t i) const noexcept -> std::uint64_t {
+        if(this->n <= 1u) { return i; }
+        do { i = this->encrypt(i); } while(i >= this->n);
+        return i;
+    }
+
+    auto inverse(std::uint64_t j) const noexcept -> std::uint64_t {
+        if(this->n <= 1u) { return j; }
+        do { j = this->decrypt(j); } while(j >= this->n);
+        return j;
+    }
+
+    template<typename OutputIt>
+        auto permute(std::uint64_t first, std::uint64_t count, OutputIt it)
+            const -> OutputIt
+        {
+            for(auto i = first, e = first + count; i != e; ++i) {
+                *it++ = this->permute(i);
+            }
+            return it;
+        }
+
+    auto operator[](std::uint64_t i) const noexcept -> std::uint64_t {
+        return this->permute(i);
+    }
+
+    inline auto begin() const noexcept -> Iterator;
+    inline auto end() const noexcept -> Iterator;
+
+private:
+    std::uint64_t n;
+    unsigned halfBits;
+    std::uint64_t mask;
+    std::array<std::uint64_t,kRounds> keys{};
+
+    auto round(std::uint64_t half, unsigned k) const noexcept
+        -> std::uint64_t
+    {
+        return RandomUtilDetail::Mix64(half + this->keys[k]) & this->mask;
+    }
+
+    auto encrypt(std::uint64_t x) const noexcept -> std::uint64_t {
+        auto l = x >> this->halfBits, r = x & this->mask;
+        for(unsigned k = 0; k < kRounds; ++k) {
+            auto t = l ^ this->round(r, k);
+            l = r;
+            r = t;
+        }
+        return l << this->halfBits | r;
+    }
+
+    auto decrypt(std::uint64_t x) const noexcept -> std::uint64_t {
+        auto l = x >> this->halfBits, r = x & this->mask;
+        for(unsigned k = kRounds; k-- > 0;) {
+            auto t = r ^ this->round(l, k);
+            r = l;
+            l = t;
+        }
+        return l << this->halfBits | r;
+    }
+};
+
+/*---- RandomPermutation::Iterator --------------------------------------------
+ *
+ *  A random-access iterator yielding permute(0), permute(1), ... by value.
+ *  It stores only a pointer to its RandomPermutation and a position, so the
+ *  permutation must outlive it.
+ */
+
+class RandomPermutation::Iterator {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::uint64_t;
+    using difference_type = std::int64_t;
+    using pointer = void;
+    using reference = std::uint64_t;
+
+    constexpr Iterator() noexcept = default;
+    constexpr Iterator(const RandomPermutation* perm, std::uint64_t i)
+        noexcept: perm{perm}, i{i} {}
+
+    auto operator*() const noexcept -> std::uint64_t {
+        return this->perm->permute(this->i);
+    }
+    auto operator[](difference_type d) const noexcept -> std::uint64_t {
+        return this->perm->permute(this->i + d);
+    }
+    auto index() const noexcept -> std::uint64_t { return this->i; }
+
+    auto operator++() noexcept -> Iterator& { ++this->i; return *this; }
+    auto operator--() noexcept -> Iterator& { --this->i; return *this; }
+    auto operator++(int) noexcept -> Iterator {
+        auto it = *this; ++this->i; return it;
+    }
+    auto operator--(int) noexcept -> Iterator {
+        auto it = *this; --this->i; return it;
+    }
+    auto operator+=(difference_type d) noexcept -> Iterator& {
+        this->i += d; return *this;
+    }
+    auto operator-=(difference_type d) noexcept -> Iterator& {
+        this->i -= d; return *this;
+    }
+
+    friend auto operator+(Iterator it, difference_type d) noexcept
+        -> Iterator { return it += d; }
+    friend auto operator+(difference_type d, Iterator it) noexcept
+        -> Iterator { return it += d; }
+    friend auto operator-(Iterator it, difference_type d) noexcept
+        -> Iterator { return it -= d; }
+    friend auto operator-(const Iterator& a, const Iterator& b) noexcept
+        -> difference_type
+    {
+        return static_cast<difference_type>(a.i - b.i);
+    }
+
+    friend auto operator==(const Iterator& a, const Iterator& b) noexcept
+        -> bool { return a.i == b.i; }
+    friend auto operator!=(const Iterator& a, const Iterator& b) noexcept
+        -> bool { return a.i != b.i; }
+    friend auto operator<(const Iterator& a, const Iterator& b) noexcept
+        -> bool { return a.i < b.i; }
+    friend auto operator>(const Iterator& a, const Iterator& b) noexcept
+        -> bool { return a.i > b.i; }
+    friend auto operator<=(const Iterator& a, const Iterator& b) noexcept
+        -> bool { return a.i <= b.i; }
+    friend auto operator>=(const Iterator& a, const Iterator& b) noexcept
+        -> bool { return a.i >= b.i; }
+
+private:
+    const RandomPermutation* perm = nullptr;
+    std::uint64_t i = 0;
+};
+
+inline auto RandomPermutation::begin() const noexcept -> Iterator {
+    return Iterator{this, 0};
+}
+inline auto RandomPermutation::end() const noexcept -> Iterator {
+    return Iterator{this, this->n};
+}
+
+/*---- Sampling ---------------------------------------------------------------
+ *
+ *  Sampling is a namespace of stratified space-filling designs for parameter
+ *  sweeps. Unlike plain uniform draws, they guarantee that every region of
+ *  each axis is visited, so far fewer samples are needed for good coverage.
+ *
+ *  Two designs are provided:
+ *
+ *      LatinHypercube(samples, dims):
+ *          Divides each axis into as many equal strata as there are samples
+ *          and places exactly one sample in each stratum of each axis. The
+ *          strata are matched up across axes by an independent random
+ *          permutation per dimension.
+ *
+ *      JitteredGrid(strata, dims):
+ *          Divides each axis into the given number of strata and places one
+ *          sample uniformly at random inside every cell of the resulting
+ *          grid, for strata^dims samples in all. With dims == 1, this is
+ *          classic stratified sampling of an interval.
+ *
+ *  Both write samples*dims doubles in [0.0,1.0) through a random-access
+ *  iterator, in either of two layouts:
+ *
+ *      kRowMajor:      sample after sample (x0 y0 x1 y1 ...)
+ *      kColumnMajor:   dimension after dimension (x0 x1 ... y0 y1 ...)
+ *
+ *  Methods:
+ *      generate(g, it, layout = kRowMajor):
+ *          Fills the whole design using random engine g.
+ *      generateDim(j, g, it, layout = kRowMajor):
+ *          Fills only dimension j of the design starting at it. Dimensions
+ *          are independent of one another, so they can be filled
+ *          concurrently, each with its own engine.
+ *      samples(), dims(), size():
+ *          Return the sample count, dimension count and their product.
+ *
+ *  Example:
+ *
+ *      //  Fill a 1000 x 8 column-major design with one thread and one
+ *      //  engine per dimension.
+ *      Sampling::LatinHypercube lhs{1000, 8};
+ *      std::vector<double> data(lhs.size());
+ *      std::vector<std::thread> threads;
+ *      for(std::size_t j = 0; j < lhs.dims(); ++j) {
+ *          threads.emplace_back([&, j] {
+ *              auto mt = MakeMTEngine();
+ *              lhs.generateDim(j, mt, data.begin(), Sampling::kColumnMajor);
+ *          });
+ *      }
+ *      for(auto& t: threads) { t.join(); }
+ */
+
+namespace Sampling {
+
+    using Layout = std::uint_least32_t;
+
+    inline constexpr Layout kRowMajor    = 0x00000000;
+    inline constexpr Layout kColumnMajor = 0x00000001;
+
+    //---- LatinHypercube -----------------------------------------------------
+
+    class LatinHypercube {
+    public:
+        constexpr LatinHypercube(std::size_t samples, std::size_t dims)
+            noexcept: sampleCount{samples}, dimCount{dims} {}
+
+        constexpr auto samples() const noexcept -> std::size_t {
+            return this->sampleCount;
+        }
+        constexpr auto dims() const noexcept -> std::size_t {
+            return this->dimCount;
+        }
+        constexpr auto size() const noexcept -> std::size_t {
+            return this->sampleCount * this->dimCount;
+        }
+
+        template<typename URBG, typename RandomIt>
+            void generateDim(
+                std::size_t j, URBG& g, RandomIt it, Layout layout = kRowMajor
+                ) const
+            {
+                auto n = this->sampleCount;
+                auto stride = static_cast<std::ptrdiff_t>(
+                    layout == kColumnMajor ? 1u : this->dimCount
+                    );
+                it += static_cast<std::ptrdiff_t>(
+                    layout == kColumnMajor ? j * n : j
+                    );
+
+                //  The column itself serves as scratch space for the stratum
+                //  permutation: write the identity, Fisher-Yates shuffle it,
+                //  then jitter each stratum index within its stratum.
+                for(std::size_t i = 0; i < n; ++i) {
+                    it[i * stride] = static_cast<double>(i);
+                }
+                for(auto i = n; i > 1u; --i) {
+                    auto k = RandomUtilDetail::Bounded(g, i);
+                    std::swap(it[(i - 1) * stride], it[k * stride]);
+                }
+                double scale = 1.0 / static_cast<double>(n);
+                for(std::size_t i = 0; i < n; ++i) {
+                    auto u = RandomUtilDetail::ToUnit(
+                        RandomUtilDetail::Bits64(g)
+                        );
+                    //  With u near 1 in the last stratum, the product can
+                    //  round up to 1.0, so clamp to the largest double below.
+                    auto x = (it[i * stride] + u) * scale;
+                    it[i * stride] = x < 1.0 ? x : 1.0 - 0x1p-53;
+                }
+            }
+
+        template<typename URBG, typename RandomIt>
+            void generate(URBG& g, RandomIt it, Layout layout = kRowMajor)
+                const
+            {
+                for(std::size_t j = 0; j < this->dimCount; ++j) {
+                    this->generateDim(j, g, it, layout);
+                }
+            }
+
+    private:
+        std::size_t sampleCount;
+        std::size_t dimCount;
+    };
+
+    //---- JitteredGrid -------------------------------------------------------
+
+    class JitteredGrid {
+    public:
+        JitteredGrid(std::size_t strata, std::size_t dims):
+            strataCount{strata}, dimCount{dims}, sampleCount{1}
+        {
+            for(std::size_t j = 0; j < dims; ++j) {
+                if(strata && this->sampleCount >
+                    std::numeric_limits<std::size_t>::max() / strata)
+                {
+                    throw std::length_error{
+                        "Sampling::JitteredGrid: strata^dims overflows"
+                        };
+                }
+                this->sampleCount *= strata;
+            }
+        }
+
+        auto strata() const noexcept -> std::size_t {
+            return this->strataCount;
+        }
+        auto samples() const noexcept -> std::size_t {
+            return this->sampleCount;
+        }
+        auto dims() const noexcept -> std::size_t { return this->dimCount; }
+        auto size() const noexcept -> std::size_t {
+            return this->sampleCount * this->dimCount;
+        }
+
+        template<typename URBG, typename RandomIt>
+            void generateDim(
+                std::size_t j, URBG& g, RandomIt it, Layout layout = kRowMajor
+                ) const
+            {
+                auto n = this->sampleCount, k = this->strataCount;
+                auto stride = static_cast<std::ptrdiff_t>(
+                    layout == kColumnMajor ? 1u : this->dimCount
+                    );
+                it += static_cast<std::ptrdiff_t>(
+                    layout == kColumnMajor ? j * n : j
+                    );
+
+                //  Sample i sits in cell (i / k^j) % k along dimension j, so
+                //  the cell index repeats in runs of k^j.
+                std::size_t run = 1;
+                for(std::size_t d = 0; d < j; ++d) { run *= k; }
+                double scale = 1.0 / static_cast<double>(k);
+                for(std::size_t i = 0; i < n; ++i) {
+                    auto cell = static_cast<double>((i / run) % k);
+                    auto u = RandomUtilDetail::ToUnit(
+                        RandomUtilDetail::Bits64(g)
+                        );
+                    auto x = (cell + u) * scale;
+                    it[i * stride] = x < 1.0 ? x : 1.0 - 0x1p-53;
+                }
+            }
+
+        template<typename URBG, typename RandomIt>
+            void generate(URBG& g, RandomIt it, Layout layout = kRowMajor)
+                const
+            {
+                for(std::size_t j = 0; j < this->dimCount; ++j) {
+                    this->generateDim(j, g, it, layout);
+                }
+            }
+
+    private:
+        std::size_t strataCount;
+        std::size_t dimCount;
+        std::size_t sampleCount;
+    };
+}
+
+/*---- Geometric --------------------------------------------------------------
+ *
+ *  Geometric is a namespace of batch generators for uniformly distributed
+ *  geometric objects, as used in physics and graphics simulations.
+ *
+ *  Outputs are written in structure-of-arrays (SoA) form: rather than one
+ *  array of interleaved coordinates, you pass an array of per-axis pointers
+ *  (axes[j] points to count values of coordinate j). Work proceeds in
+ *  blocks: the random deviates for a block are generated straight into the
+ *  output arrays, then transformed by simple loops over contiguous memory
+ *  that compilers can vectorize.
+ *
+ *  Functions (Real is float or double):
+ *
+ *      OnSphere(g, count, dims, Real* const* axes):
+ *          Unit vectors uniformly distributed on the sphere S^(dims-1),
+ *          obtained by normalizing standard normal vectors.
+ *
+ *      InBall(g, count, dims, Real* const* axes):
+ *          Points uniformly distributed in the unit dims-ball: a point on
+ *          the sphere scaled by U^(1/dims).
+ *
+ *      OnSimplex(g, count, dims, Real* const* axes):
+ *          Points uniformly distributed on the probability simplex
+ *          {x : x_j >= 0, sum x_j == 1} (i.e. flat Dirichlet), obtained by
+ *          normalizing standard exponentials.
+ *
+ *      InSimplex(g, count, dims, Real* const* axes):
+ *          Points uniformly distributed in the corner simplex
+ *          {x : x_j >= 0, sum x_j <= 1}.
+ *
+ *      Quaternions(g, count, Real* const* wxyz):
+ *          Uniformly distributed unit quaternions (4 output arrays, w first)
+ *          by Shoemake's method. These represent Haar-random 3D rotations
+ *          and are the cheapest way to obtain them.
+ *
+ *      Rotations3(g, count, Real* const* m):
+ *          Haar-random 3x3 rotation matrices via Quaternions. m holds 9
+ *          output arrays for the elements in row-major order (m[3*r + c]).
+ *
+ *      Rotation(g, dims, Real* m):
+ *          A single Haar-random rotation matrix in SO(dims), written
+ *          row-major and contiguously to m[0,dims*dims). It orthonormalizes
+ *          a Gaussian matrix by modified Gram-Schmidt (O(dims^3)) and
+ *          flips one column if needed to make the determinant +1.
+ *
+ *  Example:
+ *
+ *      std::vector<float> x(n), y(n), z(n);
+ *      float* dirs[] = {x.data(), y.data(), z.data()};
+ *      auto mt = MakeMTEngine();
+ *      Geometric::OnSphere(mt, n, 3, dirs);
+ */
+
+namespace Geometric {
+
+    inline constexpr std::size_t kBlock = 256;
+
+    template<typename URBG, typename Real>
+        void OnSphere(
+            URBG& g, std::size_t count, std::size_t dims, Real* const* axes
+            )
+        {
+            std::array<Real,kBlock> norm2;
+            for(std::size_t i0 = 0; i0 < count; i0 += kBlock) {
+                auto m = std::min(kBlock, count - i0);
+                std::fill_n(norm2.begin(), m, Real{0});
+                for(std::size_t j = 0; j < dims; ++j) {
+                    Real* x = axes[j] + i0;
+                    RandomUtilDetail::FillStandardNormal(g, x, m);
+                    for(std::size_t i = 0; i < m; ++i) {
+                        norm2[i] += x[i] * x[i];
+                    }
+                }
+
+                //  A zero vector is possible in principle (if vanishingly
+                //  rare), so it is guarded against rather than divided by.
+                for(std::size_t i = 0; i < m; ++i) {
+                    norm2[i] = norm2[i] > Real{0} ?
+                        Real{1} / std::sqrt(norm2[i]) : Real{0};
+                }
+                for(std::size_t j = 0; j < dims; ++j) {
+                    Real* x = axes[j] + i0;
+                    for(std::size_t i = 0; i < m; ++i) {
+                        x[i] *= norm2[i];
+                    }
+                }
+            }
+        }
+
+    template<typename URBG, typename Real>
+        void InBall(
+            URBG& g, std::size_t count, std::size_t dims, Real* const* axes
+            )
+        {
+            OnSphere(g, count, dims, axes);
+            std::array<Real,kBlock> r;
+            Real power = Real{1} / static_cast<Real>(dims);
+            for(std::size_t i0 = 0; i0 < count; i0 += kBlock) {
+                auto m = std::min(kBlock, count - i0);
+                for(std::size_t i = 0; i < m; ++i) {
+                    r[i] = static_cast<Real>(
+                        RandomUtilDetail::ToUnit(RandomUtilDetail::Bits64(g))
+                        );
+                }
+                for(std::size_t i = 0; i < m; ++i) {
+                    r[i] = std::pow(r[i], power);
+                }
+                for(std::size_t j = 0; j < dims; ++j) {
+                    Real* x = axes[j] + i0;
+                    for(std::size_t i = 0; i < m; ++i) {
+                        x[i] *= r[i];
+                    }
+                }
+            }
+        }
+
+    //  Shared by OnSimplex and InSimplex. The latter normalizes dims + 1
+    //  exponentials and drops the last, whose values go to a scratch block.
+    template<typename URBG, typename Real>
+        void SimplexImpl(
+            URBG& g, std::size_t count, std::size_t dims, Real* const* axes,
+            bool interior
+            )
+        {
+            std::array<Real,kBlock> sum, slack;
+            for(std::size_t i0 = 0; i0 < count; i0 += kBlock) {
+                auto m = std::min(kBlock, count - i0);
+                if(interior) {
+                    RandomUtilDetail::FillStandardExponential(
+                        g, slack.data(), m
+                        );
+                    std::copy_n(slack.begin(), m, sum.begin());
+                }
+                else {
+                    std::fill_n(sum.begin(), m, Real{0});
+                }
+                for(std::size_t j = 0; j < dims; ++j) {
+                    Real* x = axes[j] + i0;
+                    RandomUtilDetail::FillStandardExponential(g, x, m);
+                    for(std::size_t i = 0; i < m; ++i) {
+                        sum[i] += x[i];
+                    }
+                }
+                for(std::size_t i = 0; i < m; ++i) {
+                    sum[i] = Real{1} / sum[i];
+                }
+                for(std::size_t j = 0; j < dims; ++j) {
+                    Real* x = axes[j] + i0;
+                    for(std::size_t i = 0; i < m; ++i) {
+                        x[i] *= sum[i];
+                    }
+                }
+            }
+        }
+
+    template<typename URBG, typename Real>
+        void OnSimplex(
+            URBG& g, std::size_t count, std::size_t dims, Real* const* axes
+            )
+        {
+            SimplexImpl(g, count, dims, axes, false);
+        }
+
+    template<typename URBG, typename Real>
+        void InSimplex(
+            URBG& g, std::size_t count, std::size_t dims, Real* const* axes
+            )
+        {
+            SimplexImpl(g, count, dims, axes, true);
+        }
+
+    template<typename URBG, typename Real>
+        void Quaternions(URBG& g, std::size_t count, Real* const* wxyz) {
+            std::array<double,kBlock> u1, u2, u3;
+            for(std::size_t i0 = 0; i0 < count; i0 += kBlock) {
+                auto m = std::min(kBlock, count - i0);
+                for(std::size_t i = 0; i < m; ++i) {
+                    using RandomUtilDetail::Bits64;
+                    using RandomUtilDetail::ToUnit;
+                    u1[i] = ToUnit(Bits64(g));
+                    u2[i] = ToUnit(Bits64(g)) * RandomUtilDetail::kTwoPi;
+                    u3[i] = ToUnit(Bits64(g)) * RandomUtilDetail::kTwoPi;
+                }
+                Real* w = wxyz[0] + i0;
+                Real* x = wxyz[1] + i0;
+                Real* y = wxyz[2] + i0;
+                Real* z = wxyz[3] + i0;
+                for(std::size_t i = 0; i < m; ++i) {
+                    double a = std::sqrt(1.0 - u1[i]), b = std::sqrt(u1[i]);
+                    w[i] = static_cast<Real>(b * std::cos(u3[i]));
+                    x[i] = static_cast<Real>(a * std::sin(u2[i]));
+                    y[i] = static_cast<Real>(a * std::cos(u2[i]));
+                    z[i] = static_cast<Real>(b * std::sin(u3[i]));
+                }
+            }
+        }
+
+    template<typename URBG, typename Real>
+        void Rotations3(URBG& g, std::size_t count, Real* const* m) {
+            std::array<Real,kBlock> w, x, y, z;
+            for(std::size_t i0 = 0; i0 < count; i0 += kBlock) {
+                auto n = std::min(kBlock, count - i0);
+                Real* q[] = {w.data(), x.data(), y.data(), z.data()};
+                Quaternions(g, n, q);
+                for(std::size_t i = 0; i < n; ++i) {
+                    Real xx = x[i] * x[i], yy = y[i] * y[i], zz = z[i] * z[i];
+                    Real xy = x[i] * y[i], xz = x[i] * z[i], yz = y[i] * z[i];
+                    Real wx = w[i] * x[i], wy = w[i] * y[i], wz = w[i] * z[i];
+                    m[0][i0 + i] = 1 - 2 * (yy + zz);
+                    m[1][i0 + i] = 2 * (xy - wz);
+                    m[2][i0 + i] = 2 * (xz + wy);
+                    m[3][i0 + i] = 2 * (xy + wz);
+                    m[4][i0 + i] = 1 - 2 * (xx + zz);
+                    m[5][i0 + i] = 2 * (yz - wx);
+                    m[6][i0 + i] = 2 * (xz - wy);
+                    m[7][i0 + i] = 2 * (yz + wx);
+                    m[8][i0 + i] = 1 - 2 * (xx + yy);
+                }
+            }
+        }
+
+    template<typename URBG, typename Real>
+        void Rotation(URBG& g, std::size_t dims, Real* m) {
+            auto n = dims;
+            if(n == 0) { return; }
+
+            //  Work column by column on the transpose (so that each column
+            //  is contiguous), in double precision whatever Real is.
+            std::vector<double> q(n * n);
+            for(;;) {
+                RandomUtilDetail::FillStandardNormal(g, q.data(), n * n);
+                bool degenerate = false;
+                for(std::size_t c = 0; c < n && !degenerate; ++c) {
+                    double* v = &q[c * n];
+                    for(std::size_t p = 0; p < c; ++p) {
+                        const double* u = &q[p * n];
+                        double dot = 0.0;
+                        for(std::size_t r = 0; r < n; ++r) {
+                            dot += u[r] * v[r];
+                        }
+                        for(std::size_t r = 0; r < n; ++r) {
+                            v[r] -= dot * u[r];
+                        }
+                    }
+                    double norm2 = 0.0;
+                    for(std::size_t r = 0; r < n; ++r) {
+                        norm2 += v[r] * v[r];
+                    }
+                    degenerate = !(norm2 > 1e-300);
+                    double s = degenerate ? 0.0 : 1.0 / std::sqrt(norm2);
+                    for(std::size_t r = 0; r < n; ++r) { v[r] *= s; }
+                }
+                if(!degenerate) { break; }
+            }
+
+            //  Gram-Schmidt leaves R with a positive diagonal, so Q is
+            //  Haar-distributed over O(n). Its determinant (+1 or -1) is
+            //  found by elimination with partial pivoting on a copy, and
+            //  negating one column maps O(n) onto SO(n) uniformly.
+            std::vector<double> a(q);
+            bool negative = false;
+            for(std::size_t c = 0; c < n; ++c) {
+                auto piv = c;
+                for(std::size_t r = c + 1; r < n; ++r) {
+                    if(std::abs(a[c * n + r]) > std::abs(a[c * n + piv])) {
+                        piv = r;
+                    }
+                }
+                if(piv != c) {
+                    negative = !negative;
+                    for(std::size_t k = c; k < n; ++k) {
+                        std::swap(a[k * n + c], a[k * n + piv]);
+                    }
+                }
+                double d = a[c * n + c];
+                if(d < 0.0) { negative = !negative; }
+                for(std::size_t r = c + 1; r < n; ++r) {
+                    double f = a[c * n + r] / d;
+                    for(std::size_t k = c; k < n; ++k) {
+                        a[k * n + r] -= f * a[k * n + c];
+                    }
+                }
+            }
+            for(std::size_t r = 0; r < n; ++r) {
+                for(std::size_t c = 0; c < n; ++c) {
+                    double v = q[c * n + r];
+                    m[r * n + c] = static_cast<Real>(
+                        negative && c == 0 ? -v : v
+                        );
+                }
+            }
+        }
+}
+
+/*---- MultivariateNormal -----------------------------------------------------
+ *
+ *  MultivariateNormal draws vectors from N(mean, covariance). It factors the
+ *  covariance matrix once at construction (covariance = L L^T, L lower
+ *  triangular), after which each sample is mean + L z for a vector z of
+ *  independent standard normals.
+ *
+ *  For bulk output, generate() works on blocks of kBlockRows samples at a
+ *  time: it draws the whole block of z vectors in one pass, then applies
+ *  the triangular multiply in tiles of kTile columns of L^T, so that the
+ *  active part of the factor stays in cache while every row of the block
+ *  streams past it. The inner loop is a contiguous multiply-add over a row
+ *  of L^T, which compilers vectorize readily.
+ *
+ *  Cholesky with jitter fallback:
+ *      A covariance matrix estimated from data is often only positive
+ *      semi-definite, or slightly indefinite through rounding. If the plain
+ *      factorization fails, it is retried with a small "jitter" added to the
+ *      diagonal, starting at 1e-10 times the mean variance and growing by a
+ *      factor of 10 per attempt, up to kMaxJitterTries attempts. jitter()
+ *      reports what was added (0.0 if nothing). If every attempt fails, the
+ *      constructor throws std::domain_error.
+ *
+ *  Constructor args:
+ *      mean (std::vector<double>): the mean vector (its size sets dims)
+ *      covariance (std::vector<double>): dims x dims matrix, row-major
+ *          Only its lower triangle is read. std::invalid_argument is thrown
+ *          if its size is not dims * dims.
+ *
+ *  Methods:
+ *      operator()(g, it): writes one sample (dims values), without
+ *          allocating for up to kTile dims
+ *      generate(g, it, n): writes n samples as an n x dims row-major matrix
+ *      dims(), mean(), jitter()
+ *      factor(): L as a dims x dims row-major matrix
+ *
+ *  Example:
+ *
+ *      MultivariateNormal mvn{{0.0, 0.0}, {1.0, 0.9, 0.9, 1.0}};
+ *      std::vector<double> xy(2 * 1'000'000);
+ *      auto mt = MakeMTEngine();
+ *      mvn.generate(mt, xy.begin(), 1'000'000);
+ */
+
+class MultivariateNormal {
+public:
+    static constexpr std::size_t kBlockRows = 64;
+    static constexpr std::size_t kTile = 64;
+    static constexpr int kMaxJitterTries = 10;
+
+    MultivariateNormal(
+        std::vector<double> mean, std::vector<double> covariance
+        ):
+        mu{std::move(mean)}
+    {
+        auto n = this->mu.size();
+        if(covariance.size() != n * n) {
+            throw std::invalid_argument{
+                "MultivariateNormal: covariance must be dims x dims"
+                };
+        }
+        double trace = 0.0;
+        for(std::size_t i = 0; i < n; ++i) { trace += covariance[i * n + i]; }
+        double jitter = 0.0;
+        double step = n ?
+            1e-10 * std::abs(trace) / static_cast<double>(n) : 0.0;
+        if(!(step > 0.0)) { step = 1e-10; }
+        for(int attempt = 0; !this->factorize(covariance, jitter); ++attempt) {
+            if(attempt == kMaxJitterTries) {
+                throw std::domain_error{
+                    "MultivariateNormal: covariance is not positive definite"
+                    };
+            }
+            jitter = attempt ? jitter * 10.0 : step;
+        }
+        this->jitterAdded = jitter;
+    }
+
+    auto dims() const noexcept -> std::size_t { return this->mu.size(); }
+    auto mean() const noexcept -> const std::vector<double>& {
+        return this->mu;
+    }
+    auto jitter() const noexcept -> double { return this->jitterAdded; }
+
+    auto factor() const -> std::vector<double> {
+        auto n = this->mu.size();
+        std::vector<double> l(n * n);
+        for(std::size_t k = 0; k < n; ++k) {
+            for(std::size_t i = k; i < n; ++i) {
+                l[i * n + k] = this->upper[k * n + i];
+            }
+        }
+        return l;
+    }
+
+    //  A single sample of up to kTile dims is computed on the stack. Larger
+    //  ones go through generate(), whose scratch allocations are small
+    //  next to the O(dims^2) multiply.
+    template<typename URBG, typename RandomIt>
+        void operator()(URBG& g, RandomIt it) const {
+            auto n = this->mu.size();
+            if(n > kTile) {
+                this->generate(g, it, 1);
+                return;
+            }
+            std::array<double,kTile> z;
+            RandomUtilDetail::FillStandardNormal(g, z.data(), n);
+            const double* u = this->upper.data();
+            for(std::size_t i = 0; i < n; ++i) {
+                double x = this->mu[i];
+                for(std::size_t k = 0; k <= i; ++k) {
+                    x += z[k] * u[k * n + i];
+                }
+                it[i] = x;
+            }
+        }
+
+    template<typename URBG, typename RandomIt>
+        void generate(URBG& g, RandomIt it, std::size_t count) const {
+            auto n = this->mu.size();
+            if(n == 0) { return; }
+            auto rows = std::min(kBlockRows, count);
+            std::vector<double> z(rows * n), x(rows * n);
+            const double* u = this->upper.data();
+            for(std::size_t r0 = 0; r0 < count; r0 += rows) {
+                auto m = std::min(rows, count - r0);
+                RandomUtilDetail::FillStandardNormal(g, z.data(), m * n);
+                for(std::size_t r = 0; r < m; ++r) {
+                    std::copy(this->mu.begin(), this->mu.end(), &x[r * n]);
+                }
+
+                //  x_r += z_r^T L^T, computed as a sum of scaled rows of L^T
+                //  (x_r[k..n) += z_r[k] * U[k][k..n)), one tile of U rows
+                //  at a time.
+                for(std::size_t k0 = 0; k0 < n; k0 += kTile) {
+                    auto k1 = std::min(n, k0 + kTile);
+                    for(std::size_t r = 0; r < m; ++r) {
+                        double* xr = &x[r * n];
+                        const double* zr = &z[r * n];
+                        for(std::size_t k = k0; k < k1; ++k) {
+                            double zk = zr[k];
+                            const double* uk = u + k * n;
+                            for(std::size_t i = k; i < n; ++i) {
+                                xr[i] += zk * uk[i];
+                            }
+                        }
+                    }
+                }
+                it = std::copy(x.begin(), x.begin() + m * n, it);
+            }
+        }
+
+private:
+    std::vector<double> mu;
+
+    //  The factor is kept as U = L^T, row-major, so that row k of U (column
+    //  k of L) is contiguous for the multiply-add loop in generate().
+    std::vector<double> upper;
+    double jitterAdded = 0.0;
+
+    auto factorize(const std::vector<double>& cov, double jitter) -> bool {
+        auto n = this->mu.size();
+        this->upper.assign(n * n, 0.0);
+        auto& u = this->upper;
+        for(std::size_t j = 0; j < n; ++j) {
+            double d = cov[j * n + j] + jitter;
+            for(std::size_t k = 0; k < j; ++k) {
+                d -= u[k * n + j] * u[k * n + j];
+            }
+            if(!(d > 0.0)) { return false; }
+            double ljj = std::sqrt(d);
+            u[j * n + j] = ljj;
+            for(std::size_t i = j + 1; i < n; ++i) {
+                double s = cov[i * n + j];
+                for(std::size_t k = 0; k < j; ++k) {
+                    s -= u[k * n + i] * u[k * n + j];
+                }
+                u[j * n + i] = s / ljj;
+            }
+        }
+        return true;
+    }
+};
+
+/*---- FillBytes --------------------------------------------------------------
+ *
+ *  FillBytes fills a byte range with random data from an engine, copying
+ *  whole engine output words into it rather than calling the engine (or a
+ *  distribution) once per byte. Only a final partial word is split up.
+ *
+ *  Args:
+ *      g (UniformRandomBitGenerator): the engine
+ *          Engines producing full 32- or 64-bit words (including both
+ *          Mersenne Twisters) are used directly; any other engine is first
+ *          widened to 64-bit words.
+ *      bgnPtr, endPtr (std::byte*): the range to fill
+ *
+ *  Example:
+ *      std::array<std::byte,32> key;
+ *      auto mt = MakeMTEngine();
+ *      FillBytes(mt, key.data(), key.data() + key.size());
+ *
+ *      (Note that a Mersenne Twister is not a cryptographically secure
+ *      generator, so this is suitable for test data and identifiers, not
+ *      for secret keys.)
+ */
+
+template<typename URBG>
+    void FillBytes(URBG& g, std::byte* bgnPtr, std::byte* endPtr) {
+        using Result = typename URBG::result_type;
+        constexpr bool kFull32 = URBG::min() == 0u &&
+            static_cast<std::uint64_t>(URBG::max()) == 0xffffffffu;
+        constexpr bool kFull64 = URBG::min() == 0u &&
+            static_cast<std::uint64_t>(URBG::max()) == 0xffffffffffffffffu;
+        using Word = std::conditional_t<
+            kFull32, std::uint32_t, std::uint64_t
+            >;
+        auto draw = [&g]() -> Word {
+            if constexpr(kFull32 || kFull64) {
+                return static_cast<Word>(static_cast<Result>(g()));
+            }
+            else {
+                return RandomUtilDetail::Bits64(g);
+            }
+        };
+        for(; endPtr - bgnPtr >= std::ptrdiff_t{sizeof(Word)};
+            bgnPtr += sizeof(Word))
+        {
+            Word w = draw();
+            std::memcpy(bgnPtr, &w, sizeof w);
+        }
+        if(bgnPtr != endPtr) {
+            Word w = draw();
+            std::memcpy(bgnPtr, &w, static_cast<std::size_t>(endPtr - bgnPtr));
+        }
+    }
+
+/*---- Uuid -------------------------------------------------------------------
+ *
+ *  Uuid is a namespace for generating RFC 9562 universally unique
+ *  identifiers from the header's engines.
+ *
+ *  Type definitions:
+ *      Bytes: std::array<std::byte,16> holding a UUID in network order
+ *
+ *  Constants:
+ *      kTextSize: 36, the length of the canonical text form
+ *          (xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx), which is written without
+ *          a null terminator.
+ *
+ *  Function definitions:
+ *      V4(g):
+ *          Returns a version 4 UUID: 122 random bits.
+ *      V7(g):
+ *          Returns a version 7 UUID: a 48-bit Unix time stamp in
+ *          milliseconds from std::chrono::system_clock (the clock behind
+ *          SeedSource::kSystemClock) followed by 74 random bits. V7 UUIDs
+ *          generated in different milliseconds sort in time order; within a
+ *          single millisecond their order is random.
+ *      Format(bytes, out):
+ *          Writes the kTextSize-character text form of bytes to out and
+ *          returns a pointer just past it. The hex conversion is done 4
+ *          bytes at a time with 64-bit word arithmetic rather than a
+ *          per-digit table lookup.
+ *      FormatV4(g, out), FormatV7(g, out):
+ *          Shorthand for Format(V4(g), out) and Format(V7(g), out).
+ *
+ *  Example:
+ *      auto mt = MakeMTEngine();
+ *      char text[Uuid::kTextSize];
+ *      Uuid::FormatV7(mt, text);
+ *      std::cout << std::string_view(text, Uuid::kTextSize) << '\n';
+ */
+
+namespace Uuid {
+
+    using Bytes = std::array<std::byte,16>;
+
+    inline constexpr std::size_t kTextSize = 36;
+
+    template<typename URBG>
+        auto V4(URBG& g) -> Bytes {
+            Bytes b;
+            FillBytes(g, b.data(), b.data() + b.size());
+            b[6] = (b[6] & std::byte{0x0f}) | std::byte{0x40};
+            b[8] = (b[8] & std::byte{0x3f}) | std::byte{0x80};
+            return b;
+        }
+
+    template<typename URBG>
+        auto V7(URBG& g) -> Bytes {
+            using namespace std::chrono;
+            auto ms = static_cast<std::uint64_t>(
+                duration_cast<milliseconds>(
+                    system_clock::now().time_since_epoch()
+                    ).count()
+                );
+            Bytes b;
+            FillBytes(g, b.data() + 6, b.data() + b.size());
+            for(unsigned i = 0; i < 6u; ++i) {
+                b[i] = static_cast<std::byte>(ms >> 8 * (5 - i));
+            }
+            b[6] = (b[6] & std::byte{0x0f}) | std::byte{0x70};
+            b[8] = (b[8] & std::byte{0x3f}) | std::byte{0x80};
+            return b;
+        }
+
+    inline auto Format(const Bytes& b, char* out) noexcept -> char* {
+        char hex[32];
+        for(unsigned i = 0; i < 4u; ++i) {
+            RandomUtilDetail::HexEncode4(b.data() + 4 * i, hex + 8 * i);
+        }
+        std::memcpy(out, hex, 8);
+        out[8] = '-';
+        std::memcpy(out + 9, hex + 8, 4);
+        out[13] = '-';
+        std::memcpy(out + 14, hex + 12, 4);
+        out[18] = '-';
+        std::memcpy(out + 19, hex + 16, 4);
+        out[23] = '-';
+        std::memcpy(out + 24, hex + 20, 12);
+        return out + kTextSize;
+    }
+
+    template<typename URBG>
+        auto FormatV4(URBG& g, char* out) -> char* {
+            return Format(V4(g), out);
+        }
+
+    template<typename URBG>
+        auto FormatV7(URBG& g, char* out) -> char* {
+            return Format(V7(g), out);
+        }
+}
+
+/*---- RandomString -----------------------------------------------------------
+ *
+ *  RandomString writes a string of symbols drawn uniformly and
+ *  independently from an alphabet, for session IDs, API keys, test data and
+ *  so on. It makes no allocations: output goes straight to an iterator into
+ *  a buffer you provide.
+ *
+ *  Every symbol is unbiased. Rather than one distribution call per symbol,
+ *  symbols are cut from 64-bit engine words in bulk:
+ *
+ *      - If the alphabet size k is a power of two, each word is simply
+ *        split into log2(k)-bit fields.
+ *
+ *      - Otherwise, each word yields a batch of m symbols, where m is the
+ *        largest count with k^m <= 2^48. The word is multiplied by k
+ *        repeatedly, the high half of each 128-bit product giving one
+ *        symbol and the low half carrying forward, and the batch is
+ *        rejected in the rare case that the final low half falls below
+ *        2^64 mod k^m (Brackett-Rochra and Lemire, "Batched Ranged Random
+ *        Integer Generation", 2024). This keeps the rejection probability
+ *        under 2^-16 per word.
+ *
+ *  Args:
+ *      g (UniformRandomBitGenerator): the engine
+ *      alphabet (std::string_view): the symbols to choose from
+ *          Duplicated characters are allowed (and weighted accordingly).
+ *          std::invalid_argument is thrown if it is empty and length > 0.
+ *      length (std::size_t): number of symbols to write
+ *      it (OutputIt): destination for the symbols
+ *
+ *  Returns:
+ *      OutputIt: the iterator just past the last symbol written
+ *
+ *  Example:
+ *      constexpr std::string_view kBase62 =
+ *          "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+ *      char token[22];
+ *      auto mt = MakeMTEngine();
+ *      RandomString(mt, kBase62, sizeof token, token);
+ */
+
+template<typename URBG, typename OutputIt>
+    auto RandomString(
+        URBG& g, std::string_view alphabet, std::size_t length, OutputIt it
+        ) -> OutputIt
+    {
+        std::uint64_t k = alphabet.size();
+        if(length == 0) { return it; }
+        if(k == 0) {
+            throw std::invalid_argument{"RandomString: empty alphabet"};
+        }
+        if(k == 1) {
+            for(; length; --length) { *it++ = alphabet[0]; }
+            return it;
+        }
+
+        if((k & (k - 1)) == 0) {
+            unsigned bits = RandomUtilDetail::CountTrailingZeros(k);
+            auto perWord = 64u / bits;
+            while(length) {
+                auto w = RandomUtilDetail::Bits64(g);
+                for(auto n = std::min<std::size_t>(perWord, length); n; --n) {
+                    *it++ = alphabet[w & (k - 1)];
+                    w >>= bits;
+                    --length;
+                }
+            }
+            return it;
+        }
+
+        unsigned perWord = 0;
+        std::uint64_t product = 1;
+        while(product <= (std::uint64_t{1} << 48) / k) {
+            product *= k;
+            ++perWord;
+        }
+        std::uint64_t threshold = (0u - product) % product;
+        std::array<std::uint64_t,48> batch;
+        while(length) {
+            std::uint64_t lo;
+            do {
+                lo = RandomUtilDetail::Bits64(g);
+                for(unsigned i = 0; i < perWord; ++i) {
+                    batch[i] = RandomUtilDetail::MulHiLo64(lo, k, lo);
+                }
+            } while(lo < threshold);
+            auto n = std::min<std::size_t>(perWord, length);
+            for(std::size_t i = 0; i < n; ++i) {
+                *it++ = alphabet[batch[i]];
+            }
+            length -= n;
+        }
+        return it;
+    }
+
+/*---- LowPrecision -----------------------------------------------------------
+ *
+ *  LowPrecision is a namespace for generating random numbers directly in
+ *  reduced-precision floating-point formats, as used for machine learning
+ *  weights and activations.
+ *
+ *  Type definitions:
+ *      Minifloat<Storage,ExpBits,ManBits,FiniteOnly>:
+ *          A bare storage class for a binary floating-point format with the
+ *          given exponent and (stored) mantissa widths. Its only member is
+ *          the bit pattern, bits. It converts explicitly to float, and
+ *          FromFloat() converts a float to it by rounding to nearest-even.
+ *          If FiniteOnly is true, the format has no infinities and only the
+ *          all-ones pattern (either sign) is NaN, as in the OCP FP8 E4M3
+ *          format; overflowing values saturate to the largest finite value.
+ *          Otherwise it follows IEEE 754 conventions and overflows to
+ *          infinity.
+ *
+ *      BFloat16:   8 exponent bits, 7 mantissa bits (brain float)
+ *      Float16:    5 exponent bits, 10 mantissa bits (IEEE binary16)
+ *      Float8E4M3: 4 exponent bits, 3 mantissa bits (OCP E4M3, finite only)
+ *      Float8E5M2: 5 exponent bits, 2 mantissa bits (OCP E5M2)
+ *
+ *  Function definitions:
+ *      FillUniform(g, bgnIt, endIt):
+ *          Fills a range of one of the above types with uniform values in
+ *          [0.0,1.0). With p = ManBits + 1 bits of precision, each value is
+ *          k / 2^p for a uniformly drawn p-bit integer k, like
+ *          std::generate_canonical at that precision. Every such value is
+ *          exactly representable, so the bit pattern for each k comes from
+ *          a precomputed table and no floating-point math is performed.
+ *          Only p random bits are spent per value (8 for BFloat16, 11 for
+ *          Float16, 4 or 3 for the FP8 formats), cut from 64-bit words.
+ *      FillUniform(g, bgnIt, endIt, a, b):
+ *          As above but scaled to [a,b) in float arithmetic, then rounded
+ *          to the target format (so b itself may occur after rounding).
+ *      FillNormal(g, bgnIt, endIt, mean = 0.0f, stddev = 1.0f):
+ *          Fills a range with normal deviates. They are computed by the
+ *          Box-Muller transform in single precision from two 24-bit
+ *          uniforms, so one 64-bit engine word gives two values (tails are
+ *          therefore cut off beyond about 5.8 standard deviations, far past
+ *          anything these formats resolve meaningfully), then rounded to
+ *          the target format.
+ *
+ *  Example:
+ *      std::vector<LowPrecision::BFloat16> weights(1 << 24);
+ *      auto mt = MakeMTEngine();
+ *      LowPrecision::FillNormal(mt, weights.begin(), weights.end(), 0.0f,
+ *          0.02f);
+ */
+
+namespace LowPrecision {
+
+    template<
+        typename Storage, unsigned ExpBits, unsigned ManBits, bool FiniteOnly
+        >
+        struct Minifloat {
+            static_assert(ExpBits + ManBits + 1 == 8 * sizeof(Storage));
+            static_assert(ExpBits <= 8 && ManBits <= 22);
+
+            using storage_type = Storage;
+
+            static constexpr unsigned kExpBits = ExpBits;
+            static constexpr unsigned kManBits = ManBits;
+            static constexpr bool kFiniteOnly = FiniteOnly;
+            static constexpr int kBias = (1 << (ExpBits - 1)) - 1;
+
+            Storage bits;
+
+            static constexpr auto FromBits(Storage bits) noexcept
+                -> Minifloat { return Minifloat{bits}; }
+
+            static auto FromFloat(float f) noexcept -> Minifloat {
+                std::uint32_t u;
+                std::memcpy(&u, &f, sizeof u);
+                std::uint32_t sign = (u >> 31) << (ExpBits + ManBits);
+                std::uint32_t a = u & 0x7fffffffu;
+                constexpr std::uint32_t kExpMax = (1u << ExpBits) - 1u;
+                constexpr std::uint32_t kManMask = (1u << ManBits) - 1u;
+                constexpr std::uint32_t kInf = kExpMax << ManBits;
+                constexpr std::uint32_t kMaxFinite = FiniteOnly ?
+                    kInf | (kManMask - 1u) : kInf - 1u;
+                auto make = [sign](std::uint32_t b) {
+                    return Minifloat{static_cast<Storage>(sign | b)};
+                };
+
+                if(a > 0x7f800000u) {
+                    return make(FiniteOnly ?
+                        kInf | kManMask : kInf | (1u << (ManBits - 1)));
+                }
+                if constexpr(ExpBits == 8) {
+
+                    //  Same exponent range as float (bfloat16): round the
+                    //  top bits to nearest-even, carrying into the exponent
+                    //  (and on to infinity) as needed.
+                    constexpr unsigned kShift = 23 - ManBits;
+                    std::uint32_t half = (1u << (kShift - 1)) - 1u;
+                    a = (a + half + ((a >> kShift) & 1u)) >> kShift;
+                    return make(a);
+                }
+                else {
+                    if(a == 0x7f800000u) {
+                        return make(FiniteOnly ? kMaxFinite : kInf);
+                    }
+
+                    //  te is the exponent biased for the target format.
+                    //  When it is below 1, the result is subnormal and the
+                    //  significand is shifted further right to match.
+                    int te = static_cast<int>(a >> 23) - 127 + kBias;
+                    std::uint32_t sig = (a & 0x7fffffu) | 0x800000u;
+                    int shift = 23 - static_cast<int>(ManBits) +
+                        (te < 1 ? 1 - te : 0);
+                    if((a >> 23) == 0u || shift > 24) {
+                        return make(0u);
+                    }
+                    std::uint32_t r = sig >> shift;
+                    std::uint32_t rem = sig & ((1u << shift) - 1u);
+                    std::uint32_t halfway = 1u << (shift - 1);
+                    if(rem > halfway || (rem == halfway && (r & 1u))) {
+                        ++r;
+                    }
+                    std::uint32_t b = te >= 1 ?
+                        (static_cast<std::uint32_t>(te - 1) << ManBits) + r :
+                        r;
+                    if(b > kMaxFinite) {
+                        b = FiniteOnly ? kMaxFinite : kInf;
+                    }
+                    return make(b);
+                }
+            }
+
+            explicit operator float() const noexcept {
+                constexpr std::uint32_t kExpMax = (1u << ExpBits) - 1u;
+                constexpr std::uint32_t kManMask = (1u << ManBits) - 1u;
+                std::uint32_t b = this->bits;
+                bool negative = (b >> (ExpBits + ManBits)) & 1u;
+                std::uint32_t e = (b >> ManBits) & kExpMax;
+                std::uint32_t m = b & kManMask;
+                float v;
+                if constexpr(ExpBits == 8) {
+                    std::uint32_t u = b << (23 - ManBits);
+                    std::memcpy(&v, &u, sizeof v);
+                    return v;
+                }
+                if(e == kExpMax && (FiniteOnly ? m == kManMask : true)) {
+                    v = m || FiniteOnly ?
+                        std::numeric_limits<float>::quiet_NaN() :
+                        std::numeric_limits<float>::infinity();
+                }
+                else if(e == 0u) {
+                    v = std::ldexp(
+                        static_cast<float>(m), 1 - kBias - int{ManBits}
+                        );
+                }
+                else {
+                    v = std::ldexp(
+                        static_cast<float>(m | (1u << ManBits)),
+                        static_cast<int>(e) - kBias - int{ManBits}
+                        );
+                }
+                return negative ? -v : v;
+            }
+        };
+
+    using BFloat16 = Minifloat<std::uint16_t,8,7,false>;
+    using Float16 = Minifloat<std::uint16_t,5,10,false>;
+    using Float8E4M3 = Minifloat<std::uint8_t,4,3,true>;
+    using Float8E5M2 = Minifloat<std::uint8_t,5,2,false>;
+
+    template<typename URBG, typename RandomIt>
+        void FillUniform(URBG& g, RandomIt bgnIt, RandomIt endIt) {
+            using T = typename std::iterator_traits<RandomIt>::value_type;
+            constexpr unsigned kBits = T::kManBits + 1;
+            constexpr unsigned kPerWord = 64 / kBits;
+            static const auto kTable = [] {
+                std::array<T,std::size_t{1} << kBits> table;
+                for(std::size_t k = 0; k < table.size(); ++k) {
+                    table[k] = T::FromFloat(std::ldexp(
+                        static_cast<float>(k), -static_cast<int>(kBits)
+                        ));
+                }
+                return table;
+            }();
+            constexpr std::uint64_t kMask = (std::uint64_t{1} << kBits) - 1u;
+            while(bgnIt != endIt) {
+                auto w = RandomUtilDetail::Bits64(g);
+                for(unsigned i = 0; i < kPerWord && bgnIt != endIt; ++i) {
+                    *bgnIt++ = kTable[w & kMask];
+                    w >>= kBits;
+                }
+            }
+        }
+
+    template<typename URBG, typename RandomIt>
+        void FillUniform(
+            URBG& g, RandomIt bgnIt, RandomIt endIt, float a, float b
+            )
+        {
+            using T = typename std::iterator_traits<RandomIt>::value_type;
+            float scale = (b - a) * 0x1p-24f;
+            while(bgnIt != endIt) {
+                auto w = RandomUtilDetail::Bits64(g);
+                *bgnIt++ = T::FromFloat(
+                    a + static_cast<float>(w >> 40) * scale
+                    );
+                if(bgnIt != endIt) {
+                    *bgnIt++ = T::FromFloat(a +
+                        static_cast<float>((w >> 8) & 0xffffffu) * scale);
+                }
+            }
+        }
+
+    template<typename URBG, typename RandomIt>
+        void FillNormal(
+            URBG& g, RandomIt bgnIt, RandomIt endIt, float mean = 0.0f,
+            float stddev = 1.0f
+            )
+        {
+            using T = typename std::iterator_traits<RandomIt>::value_type;
+            constexpr std::size_t kBlock = 128;
+            constexpr auto kTwoPi = static_cast<float>(
+                RandomUtilDetail::kTwoPi
+                );
+            std::array<float,kBlock> r, t;
+            while(bgnIt != endIt) {
+                auto n = static_cast<std::size_t>(
+                    std::min<std::ptrdiff_t>(2 * kBlock, endIt - bgnIt)
+                    );
+                auto m = (n + 1) / 2;
+                for(std::size_t i = 0; i < m; ++i) {
+                    auto w = RandomUtilDetail::Bits64(g);
+                    r[i] = static_cast<float>((w >> 40) + 1u) * 0x1p-24f;
+                    t[i] = static_cast<float>((w >> 8) & 0xffffffu) *
+                        (0x1p-24f * kTwoPi);
+                }
+                for(std::size_t i = 0; i < m; ++i) {
+                    r[i] = stddev * std::sqrt(-2.0f * std::log(r[i]));
+                }
+                for(std::size_t i = 0; i < m; ++i) {
+                    *bgnIt++ = T::FromFloat(mean + r[i] * std::cos(t[i]));
+                }
+                for(std::size_t i = 0; i < n - m; ++i) {
+                    *bgnIt++ = T::FromFloat(mean + r[i] * std::sin(t[i]));
+                }
+            }
+        }
+}
+
+/*---- LowPrecision::StochasticRound ------------------------------------------
+ *
+ *  StochasticRound converts floats to BFloat16 or int8 by rounding each
+ *  value up or down at random, with the probability of rounding up equal to
+ *  the fraction of the gap it has covered. Unlike round-to-nearest, this is
+ *  unbiased in expectation, which keeps small gradient updates from being
+ *  lost entirely in low-precision training and quantization.
+ *
+ *  The random bits are generated a block at a time into a small stack
+ *  buffer and consumed straight away by the rounding loop, so no array of
+ *  uniforms the size of the input is ever materialized. Each value costs
+ *  16 random bits (a quarter of a 64-bit engine word):
+ *
+ *      BFloat16:
+ *          16 random bits are added to the low half of the float's bit
+ *          pattern, which is then truncated. This is exact stochastic
+ *          rounding in magnitude (and handles subnormals and overflow to
+ *          infinity naturally). NaNs and infinities are converted as by
+ *          BFloat16::FromFloat.
+ *
+ *      std::int8_t:
+ *          Each value x (after division by scale) becomes floor(x) + 1 with
+ *          probability frac(x) to 16-bit resolution, else floor(x). Results
+ *          are clamped to [-128,127], and NaNs map to 0.
+ *
+ *  Args:
+ *      g (UniformRandomBitGenerator): the engine
+ *      bgnIt, endIt (RandomIt): the float inputs
+ *      outIt (OutputIt): destination whose value_type is BFloat16 or
+ *          std::int8_t (e.g. a pointer or vector iterator)
+ *      scale (float, optional): inputs are divided by this first
+ *          Defaults to 1.0f.
+ *
+ *  Returns:
+ *      OutputIt: the iterator just past the last value written
+ *
+ *  Example:
+ *      std::vector<float> w(n);
+ *      std::vector<std::int8_t> q(n);
+ *      auto mt = MakeMTEngine();
+ *      LowPrecision::StochasticRound(mt, w.begin(), w.end(), q.begin(),
+ *          maxAbs / 127.0f);
+ */
+
+namespace LowPrecision {
+
+    template<typename URBG, typename RandomIt, typename OutputIt>
+        auto StochasticRound(
+            URBG& g, RandomIt bgnIt, RandomIt endIt, OutputIt outIt,
+            float scale = 1.0f
+            ) -> OutputIt
+        {
+            using Out = typename std::iterator_traits<OutputIt>::value_type;
+            static_assert(
+                std::is_same_v<Out,BFloat16> ||
+                std::is_same_v<Out,std::int8_t>,
+                "StochasticRound outputs BFloat16 or std::int8_t"
+                );
+            constexpr std::size_t kBlock = 256;
+            std::array<std::uint16_t,kBlock> noise;
+            float inv = 1.0f / scale;
+            while(bgnIt != endIt) {
+                auto n = static_cast<std::size_t>(std::min<std::ptrdiff_t>(
+                    kBlock, endIt - bgnIt
+                    ));
+                for(std::size_t i = 0; i < n; i += 4) {
+                    auto w = RandomUtilDetail::Bits64(g);
+                    for(std::size_t k = 0; k < 4; ++k) {
+                        noise[i + k] = static_cast<std::uint16_t>(w >> 16 * k);
+                    }
+                }
+                for(std::size_t i = 0; i < n; ++i, ++bgnIt) {
+                    float x = static_cast<float>(*bgnIt) * inv;
+                    if constexpr(std::is_same_v<Out,BFloat16>) {
+                        std::uint32_t u;
+                        std::memcpy(&u, &x, sizeof u);
+                        if((u & 0x7f800000u) == 0x7f800000u) {
+                            *outIt++ = BFloat16::FromFloat(x);
+                        }
+                        else {
+                            u += noise[i];
+                            *outIt++ = BFloat16::FromBits(
+                                static_cast<std::uint16_t>(u >> 16)
+                                );
+                        }
+                    }
+                    else {
+                        float lo = std::floor(x);
+                        float up = static_cast<float>(noise[i]) * 0x1p-16f <
+                            x - lo;
+                        float q = std::clamp(lo + up, -128.0f, 127.0f);
+                        *outIt++ = x == x ? static_cast<std::int8_t>(q) : 0;
+                    }
+                }
+            }
+            return outIt;
+        }
+}
+
+/*---- AddNoise ---------------------------------------------------------------
+ *
+ *  AddNoise adds independent random noise to every element of a range in
+ *  place, for data augmentation and differential-privacy style
+ *  perturbation. Instead of generating a noise array the size of the input
+ *  and adding it in a second pass, it generates a block of deviates into a
+ *  small stack buffer (which stays in L1 cache) and immediately accumulates
+ *  it into the data, so the data is streamed through memory only once.
+ *
+ *  The kind of noise is selected by the type of the parameter struct
+ *  passed, each of which lives in the Noise namespace:
+ *
+ *      Noise::Gaussian{mean, stddev}:
+ *          normal noise (Box-Muller); defaults to {0.0, 1.0}
+ *      Noise::Uniform{a, b}:
+ *          uniform noise over [a,b); defaults to {-1.0, 1.0}
+ *      Noise::Laplace{mu, scale}:
+ *          Laplace (double-exponential) noise with the given location and
+ *          scale b, i.e. density exp(-|x - mu| / b) / 2b; defaults to
+ *          {0.0, 1.0}. For the Laplace mechanism, choose
+ *          scale = sensitivity / epsilon.
+ *
+ *  Note that this, like any textbook floating-point Laplace sampler, does
+ *  not defend against the floating-point side channel described by Mironov
+ *  ("On Significance of the Least Significant Bits for Differential
+ *  Privacy", 2012). Where formal privacy guarantees matter, post-process the
+ *  output with a snapping or discretization scheme.
+ *
+ *  Args:
+ *      g (UniformRandomBitGenerator): the engine
+ *      bgnIt, endIt (RandomIt): the data, of float or double type
+ *      params: one of the structs above
+ *
+ *  Example:
+ *      std::vector<float> counts = ...;
+ *      auto mt = MakeMTEngine();
+ *      AddNoise(mt, counts.begin(), counts.end(), Noise::Laplace{0.0, 2.0});
+ */
+
+namespace Noise {
+
+    struct Gaussian {
+        double mean = 0.0;
+        double stddev = 1.0;
+    };
+
+    struct Uniform {
+        double a = -1.0;
+        double b = 1.0;
+    };
+
+    struct Laplace {
+        double mu = 0.0;
+        double scale = 1.0;
+    };
+
+    inline constexpr std::size_t kBlock = 256;
+}
+
+template<typename URBG, typename RandomIt>
+    void AddNoise(URBG& g, RandomIt bgnIt, RandomIt endIt, Noise::Gaussian p) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        std::array<T,Noise::kBlock> z;
+        auto mean = static_cast<T>(p.mean), stddev = static_cast<T>(p.stddev);
+        while(bgnIt != endIt) {
+            auto n = static_cast<std::size_t>(std::min<std::ptrdiff_t>(
+                Noise::kBlock, endIt - bgnIt
+                ));
+            RandomUtilDetail::FillStandardNormal(g, z.data(), n);
+            for(std::size_t i = 0; i < n; ++i) {
+                bgnIt[i] += mean + stddev * z[i];
+            }
+            bgnIt += static_cast<std::ptrdiff_t>(n);
+        }
+    }
+
+template<typename URBG, typename RandomIt>
+    void AddNoise(URBG& g, RandomIt bgnIt, RandomIt endIt, Noise::Uniform p) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        std::array<T,Noise::kBlock> u;
+        auto a = static_cast<T>(p.a), width = static_cast<T>(p.b - p.a);
+        while(bgnIt != endIt) {
+            auto n = static_cast<std::size_t>(std::min<std::ptrdiff_t>(
+                Noise::kBlock, endIt - bgnIt
+                ));
+            for(std::size_t i = 0; i < n; ++i) {
+                u[i] = static_cast<T>(
+                    RandomUtilDetail::ToUnit(RandomUtilDetail::Bits64(g))
+                    );
+            }
+            for(std::size_t i = 0; i < n; ++i) {
+                bgnIt[i] += a + width * u[i];
+            }
+            bgnIt += static_cast<std::ptrdiff_t>(n);
+        }
+    }
+
+template<typename URBG, typename RandomIt>
+    void AddNoise(URBG& g, RandomIt bgnIt, RandomIt endIt, Noise::Laplace p) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+
+        //  A Laplace deviate is an exponential one with a random sign. Each
+        //  64-bit word supplies both: its top 53 bits feed the uniform and
+        //  its lowest bit picks the sign.
+        std::array<T,Noise::kBlock> e, s;
+        auto mu = static_cast<T>(p.mu), scale = static_cast<T>(p.scale);
+        while(bgnIt != endIt) {
+            auto n = static_cast<std::size_t>(std::min<std::ptrdiff_t>(
+                Noise::kBlock, endIt - bgnIt
+                ));
+            for(std::size_t i = 0; i < n; ++i) {
+                auto w = RandomUtilDetail::Bits64(g);
+                e[i] = static_cast<T>(1.0 - RandomUtilDetail::ToUnit(w));
+                s[i] = (w & 1u) ? -scale : scale;
+            }
+            for(std::size_t i = 0; i < n; ++i) {
+                bgnIt[i] += mu - s[i] * std::log(e[i]);
+            }
+            bgnIt += static_cast<std::ptrdiff_t>(n);
+        }
+    }
+
+/*---- SeedSource::SpawnSeq ---------------------------------------------------
+ *
+ *  SpawnSeq is a SeedSequence for seeding many engines from a single draw of
+ *  entropy. It holds a 128-bit key, and spawn(i) derives the key of its i-th
+ *  child by hashing. Children can spawn children of their own, so a whole
+ *  tree of independent, reproducible streams (per thread, per task, per
+ *  batch...) can hang off one root without touching std::random_device or
+ *  the clocks again.
+ *
+ *  A root SpawnSeq gets its key from a Seq (kAll by default), costing one
+ *  random_device read. Alternatively, FromKey() makes one from a fixed key,
+ *  which makes everything spawned from it reproducible.
+ *
+ *  generate() expands the key with a SplitMix64-style hash into as many
+ *  words as the engine asks for. Unlike std::seed_seq, this allocates no
+ *  memory.
+ *
+ *  To meet the rest of the SeedSequence requirements, a SpawnSeq can also be
+ *  constructed from a range or initializer list of 32-bit words. Exactly
+ *  size() == 4 words are taken as the key, most significant first, which is
+ *  the layout param() writes, so a copy made through param() is identical.
+ *  Any other number of words is hashed into a key.
+ *
+ *  Example:
+ *
+ *      SeedSource::SpawnSeq root;
+ *      std::vector<MTEngineT> engines;
+ *      for(std::uint64_t i = 0; i < 8; ++i) {
+ *          auto child = root.spawn(i);
+ *          engines.emplace_back(child);
+ *      }
+ */
+
+namespace SeedSource {
+
+    struct SpawnSeq {
+        using result_type = Seq::result_type;
+
+        std::array<std::uint64_t,2> key;
+
+        //---- Constructors ---------------------------------------------------
+
+        SpawnSeq(): SpawnSeq{Seq{}} {}
+        explicit SpawnSeq(const Seq& seq):
+            key{RandomUtilDetail::SeedWords<2>(seq)} {}
+
+        template<typename InputIt>
+            SpawnSeq(InputIt it, InputIt endIt,
+                std::enable_if_t<not std::is_integral_v<InputIt>>* p = nullptr
+                ):
+                key{}
+            {
+                using RandomUtilDetail::Mix64;
+                std::array<std::uint64_t,4> words{};
+                std::uint64_t h = 0, n = 0;
+                for(; it != endIt; ++it, ++n) {
+                    auto v = static_cast<std::uint64_t>(*it) & 0xffffffffu;
+                    if(n < 4u) { words[n] = v; }
+                    h = Mix64(h ^ (v + 0x9e3779b97f4a7c15u * (n + 1u)));
+                }
+                if(n == 4u) {
+                    this->key = {
+                        words[0] << 32 | words[1], words[2] << 32 | words[3]
+                        };
+                }
+                else {
+                    this->key = {Mix64(h ^ n), Mix64(h + 0x6a09e667f3bcc909u)};
+                }
+            }
+        template<typename Int>
+            SpawnSeq(std::initializer_list<Int> il,
+                std::enable_if_t<std::is_integral_v<Int>>* p = nullptr
+                ):
+                SpawnSeq{il.begin(), il.end()} {}
+
+        static constexpr auto FromKey(std::uint64_t k0, std::uint64_t k1 = 0)
+            noexcept -> SpawnSeq
+        {
+            return SpawnSeq{std::array<std::uint64_t,2>{k0, k1}};
+        }
+
+        //---------------------------------------------------------------------
+
+        constexpr auto spawn(std::uint64_t index) const noexcept -> SpawnSeq {
+            using RandomUtilDetail::Mix64;
+            auto h = Mix64(index + 0x9e3779b97f4a7c15u);
+            return SpawnSeq{std::array<std::uint64_t,2>{
+                Mix64(this->key[0] ^ h),
+                Mix64(this->key[1] + Mix64(h ^ 0x6a09e667f3bcc909u))
+                }};
+        }
+
+        template<typename RandomIt>
+            void generate(RandomIt bgnIt, RandomIt endIt) const {
+                using RandomUtilDetail::Mix64;
+                std::uint64_t ctr = this->key[1];
+                for(; bgnIt != endIt; ++bgnIt) {
+                    ctr += 0x9e3779b97f4a7c15u;
+                    *bgnIt = static_cast<result_type>(
+                        Mix64(this->key[0] ^ Mix64(ctr)) & 0xffffffffu
+                        );
+                }
+            }
+
+        constexpr auto size() const noexcept -> std::size_t { return 4; }
+        template<typename It>
+            void param(It it) const {
+                for(auto k: this->key) {
+                    *it++ = static_cast<result_type>(k >> 32);
+                    *it++ = static_cast<result_type>(k & 0xffffffffu);
+                }
+            }
+
+    private:
+        constexpr explicit SpawnSeq(std::array<std::uint64_t,2> key) noexcept:
+            key{key} {}
+    };
+}
+
+/*---- ForkGeneration ---------------------------------------------------------
+ *
+ *  ForkGeneration returns a counter that changes whenever the process finds
+ *  itself to be the child of a fork(). Any engine seeded before a fork
+ *  carries identical state into every child, so every worker of a
+ *  pre-forking server would otherwise produce the same sequence. Code that
+ *  caches an engine can remember the generation it was seeded under and
+ *  reseed lazily, on its first use in a child, when the value differs.
+ *
+ *  Detection is two-fold on POSIX systems:
+ *
+ *      - A pthread_atfork() child handler bumps the counter. This covers
+ *        fork() itself and any wrapper around it.
+ *      - On Linux 4.14 and later, a canary word is kept in a page marked
+ *        MADV_WIPEONFORK, which the kernel zeroes in the child of any
+ *        fork-like clone, including raw clone() calls that bypass the
+ *        atfork handlers. Finding it zeroed also bumps the counter.
+ *
+ *  Both are set up on the first call, so call ForkGeneration() once before
+ *  forking (ThreadEngine() does so on its own). On other systems, it always
+ *  returns 0.
+ */
+
+namespace RandomUtilDetail {
+
+    //  Process-wide state for fork detection and for the root SpawnSeq that
+    //  ThreadEngine() seeds from. The lock is a spin lock rather than a
+    //  mutex so that the atfork child handler can simply clear it should a
+    //  parent thread have been holding it at the moment of the fork.
+    struct ProcessState {
+        std::atomic<std::uint64_t> generation{0};
+        std::atomic<std::uint32_t>* canary = nullptr;
+
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        bool hasRoot = false;
+        std::uint64_t rootGeneration = 0;
+        std::uint64_t spawned = 0;
+        SeedSource::SpawnSeq root = SeedSource::SpawnSeq::FromKey(0);
+    };
+
+    inline auto GetProcessState() noexcept -> ProcessState& {
+        static ProcessState* state = [] {
+            static ProcessState st;
+         #if RANDOM_UTIL_HAS_POSIX
+            pthread_atfork(nullptr, nullptr, [] {
+                auto& s = GetProcessState();
+                s.lock.clear();
+                s.generation.fetch_add(1, std::memory_order_relaxed);
+                if(s.canary) { s.canary->store(1, std::memory_order_relaxed); }
+            });
+          #if defined(MADV_WIPEONFORK)
+            auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            void* p = mmap(
+                nullptr, page, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+                );
+            if(p != MAP_FAILED) {
+                if(madvise(p, page, MADV_WIPEONFORK) == 0) {
+                    st.canary = new(p) std::atomic<std::uint32_t>{1};
+                }
+                else {
+                    munmap(p, page);
+                }
+            }
+          #endif
+         #endif
+            return &st;
+        }();
+        return *state;
+    }
+
+    //  Returns a child of the process's root SpawnSeq, first (re)drawing the
+    //  root from SeedSource if this is the first request in this process
+    //  or fork generation.
+    inline auto SpawnProcessSeq(std::uint64_t generation)
+        -> SeedSource::SpawnSeq
+    {
+        auto& st = GetProcessState();
+        while(st.lock.test_and_set(std::memory_order_acquire)) {}
+        if(!st.hasRoot || st.rootGeneration != generation) {
+            st.root = SeedSource::SpawnSeq{};
+            st.hasRoot = true;
+            st.rootGeneration = generation;
+            st.spawned = 0;
+        }
+        auto seq = st.root.spawn(st.spawned++);
+        st.lock.clear(std::memory_order_release);
+        return seq;
+    }
+}
+
+inline auto ForkGeneration() noexcept -> std::uint64_t {
+    auto& st = RandomUtilDetail::GetProcessState();
+    if(st.canary && st.canary->load(std::memory_order_relaxed) == 0u) {
+        st.canary->store(1, std::memory_order_relaxed);
+        st.generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    return st.generation.load(std::memory_order_relaxed);
+}
+
+/*---- ThreadEngine -----------------------------------------------------------
+ *
+ *  ThreadEngine returns a reference to a Mersenne Twister engine (MTEngineT)
+ *  belonging to the calling thread. Each thread's engine is created and
+ *  seeded the first time that thread calls ThreadEngine(), so threads that
+ *  never need random numbers never pay for one.
+ *
+ *  Seeding draws on SeedSource just once per process: the first call in any
+ *  thread creates a root SeedSource::SpawnSeq from a default Seq, and every
+ *  thread's engine is seeded from root.spawn(n) for a distinct n. There is
+ *  no lock on the engine itself since no two threads share one, which makes
+ *  this a cheaper alternative to storing an engine in every object or
+ *  sharing one behind a mutex.
+ *
+ *  The engines are fork-safe. Each call compares ForkGeneration() with the
+ *  generation the engine was seeded under, and if they differ (i.e. this is
+ *  the first use in a forked child), the root is redrawn from SeedSource
+ *  and the engine reseeded from it before use. Nothing is reseeded eagerly
+ *  at fork time.
+ *
+ *  Each engine's state is allocated and first written by its own thread,
+ *  on pages of its own, so on NUMA systems it sits on that thread's node
+ *  rather than wherever the thread's creator happened to run.
+ *
+ *  The reference must not be handed to other threads.
+ *
+ *  Convenience functions built on ThreadEngine():
+ *
+ *      RandomInt(a, b):
+ *          Returns a uniformly distributed integer in [a,b] (inclusive).
+ *      RandomReal(a = 0.0, b = 1.0):
+ *          Returns a uniformly distributed real number in [a,b).
+ *      RandomBool(p = 0.5):
+ *          Returns true with probability p.
+ *
+ *  Example:
+ *      auto roll = RandomInt(1, 6);
+ *      std::shuffle(v.begin(), v.end(), ThreadEngine());
+ */
+
+namespace RandomUtilDetail {
+
+    inline auto PageSize() noexcept -> std::size_t {
+     #if RANDOM_UTIL_HAS_POSIX
+        static const auto size = static_cast<std::size_t>(
+            sysconf(_SC_PAGESIZE)
+            );
+        return size;
+     #else
+        return 4096u;
+     #endif
+    }
+
+    //  Maps fresh, untouched memory for at least the given number of bytes
+    //  (rounded up to whole pages). With node < 0, the kernel places each
+    //  page on the NUMA node of the thread that first writes to it. With
+    //  node >= 0, the pages are bound to that node with mbind
+    //  (MPOL_PREFERRED, so an exhausted node falls back rather than
+    //  failing), and bound is set to whether this succeeded. Throws
+    //  std::bad_alloc if the memory cannot be mapped.
+    inline auto NumaMap(std::size_t bytes, int node, bool& bound) -> void* {
+        bound = false;
+        bytes = (bytes + PageSize() - 1) / PageSize() * PageSize();
+     #if RANDOM_UTIL_HAS_POSIX
+        void* p = mmap(
+            nullptr, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+            );
+        if(p == MAP_FAILED) { throw std::bad_alloc{}; }
+      #if defined(__linux__) && defined(SYS_mbind)
+        constexpr int kMpolPreferred = 1;
+        constexpr int kMaxNodes = 1024;
+        if(node >= 0 && node < kMaxNodes) {
+            constexpr auto kBits = std::numeric_limits<unsigned long>::digits;
+            std::array<unsigned long,kMaxNodes / kBits> mask{};
+            mask[static_cast<std::size_t>(node) / kBits] |=
+                1ul << (static_cast<unsigned>(node) % kBits);
+            bound = syscall(
+                SYS_mbind, p, bytes, kMpolPreferred, mask.data(),
+                static_cast<unsigned long>(kMaxNodes + 1), 0u
+                ) == 0;
+        }
+      #endif
+        return p;
+     #else
+        return ::operator new(bytes, std::align_val_t{PageSize()});
+     #endif
+    }
+
+    inline void NumaUnmap(void* p, std::size_t bytes) noexcept {
+        bytes = (bytes + PageSize() - 1) / PageSize() * PageSize();
+     #if RANDOM_UTIL_HAS_POSIX
+        munmap(p, bytes);
+     #else
+        ::operator delete(p, std::align_val_t{PageSize()});
+     #endif
+    }
+}
+
+inline auto ThreadEngine() -> MTEngineT& {
+    struct Slot {
+        MTEngineT engine;
+        std::uint64_t generation;
+    };
+
+    //  The slot lives on pages that the owning thread maps and writes
+    //  first, rather than in the static TLS block (which is set up by the
+    //  thread's creator), so that the engine state is local to the node
+    //  the thread runs on.
+    //
+    //  The pointer to it is a trivially destructible thread_local, so it
+    //  stays usable while the thread's other thread_local objects are
+    //  destroyed, and where possible the slot is released by a pthread key
+    //  destructor, which runs after all of those. Should a later key
+    //  destructor call ThreadEngine() again, the slot is simply mapped
+    //  anew and released in the next round of key destructors. Elsewhere,
+    //  a thread_local destructor releases it, and a call made after that
+    //  gets a fresh slot that is never released.
+    thread_local Slot* current = nullptr;
+    if(!current) {
+        auto generation = ForkGeneration();
+        auto seq = RandomUtilDetail::SpawnProcessSeq(generation);
+        bool bound;
+        void* p = RandomUtilDetail::NumaMap(sizeof(Slot), -1, bound);
+        current = new(p) Slot{MTEngineT(seq), generation};
+     #if RANDOM_UTIL_HAS_POSIX
+        static const pthread_key_t key = [] {
+            pthread_key_t k;
+            int err = pthread_key_create(&k, [](void* p) {
+                auto* s = static_cast<Slot*>(p);
+                if(current == s) { current = nullptr; }
+                s->~Slot();
+                RandomUtilDetail::NumaUnmap(s, sizeof(Slot));
+            });
+            if(err != 0) {
+                throw std::system_error{
+                    err, std::generic_category(),
+                    "ThreadEngine: pthread_key_create"
+                    };
+            }
+            return k;
+        }();
+        pthread_setspecific(key, current);
+     #else
+        struct Holder {
+            ~Holder() {
+                if(current) {
+                    current->~Slot();
+                    RandomUtilDetail::NumaUnmap(current, sizeof(Slot));
+                    current = nullptr;
+                }
+            }
+        };
+        thread_local Holder holder;
+        static_cast<void>(holder);
+     #endif
+    }
+    auto& slot = *current;
+    auto generation = ForkGeneration();
+    if(slot.generation != generation) {
+        auto seq = RandomUtilDetail::SpawnProcessSeq(generation);
+        slot.engine.seed(seq);
+        slot.generation = generation;
+    }
+    return slot.engine;
+}
+
+template<typename Int>
+    auto RandomInt(Int a, Int b) -> Int {
+        return std::uniform_int_distribution<Int>{a, b}(ThreadEngine());
+    }
+
+template<typename Real = double>
+    auto RandomReal(Real a = Real{0}, Real b = Real{1}) -> Real {
+        return std::uniform_real_distribution<Real>{a, b}(ThreadEngine());
+    }
+
+inline auto RandomBool(double p = 0.5) -> bool {
+    return std::bernoulli_distribution{p}(ThreadEngine());
+}
+
+/*---- PerCpuEngine -----------------------------------------------------------
+ *
+ *  PerCpuEngine is a lock-free random engine that any number of threads may
+ *  call concurrently. Rather than one shared state (a contention hot spot)
+ *  or one engine per thread (memory that scales with thread count), it
+ *  keeps a small engine per CPU, each in its own cache line, and a call
+ *  uses the slot of the CPU it happens to be running on.
+ *
+ *  The CPU number is read from the kernel-maintained restartable sequences
+ *  (rseq) area that glibc 2.35+ registers for every thread on Linux, which
+ *  costs a single memory load. Where rseq is unavailable, sched_getcpu() is
+ *  used instead, and on non-Linux systems a per-thread hash stands in.
+ *
+ *  Each slot is a SplitMix64 generator: a 64-bit counter advanced by an
+ *  odd per-slot increment ("gamma") and passed through a mixing function.
+ *  Since the whole state is one word, advancing it is a single atomic
+ *  fetch_add. That keeps the engine correct even when a thread is
+ *  preempted or migrated between reading its CPU number and using the slot.
+ *  The fetch_add is uncontended in the common case and stays in the local
+ *  CPU's cache, so the cost approaches that of a thread-local engine.
+ *  Distinct per-slot gammas make the slots' streams distinct sequences
+ *  rather than offsets into one.
+ *
+ *  PerCpuEngine satisfies UniformRandomBitGenerator with 64-bit output. Its
+ *  output is not reproducible, since which slot serves a call depends on
+ *  scheduling. Like ThreadEngine(), it rekeys its slots from the process
+ *  root SpawnSeq on first use after a fork (see ForkGeneration).
+ *
+ *  Constructor args:
+ *      seq (SeedSequence, optional): source of the slot keys
+ *          Defaults to a default-constructed SeedSource::Seq.
+ *      slots (std::size_t, optional): number of slots
+ *          Defaults to std::thread::hardware_concurrency(). It is rounded up
+ *          to a power of two; CPUs beyond it share slots (safely).
+ *
+ *  Function definitions:
+ *      GlobalEngine():
+ *          Returns a process-wide PerCpuEngine, created on first use.
+ *
+ *  Example:
+ *      std::uniform_int_distribution<int> dis{1, 6};
+ *      auto roll = dis(GlobalEngine());  // from any thread, no locks
+ */
+
+namespace RandomUtilDetail {
+
+    //  Returns the number of the CPU the calling thread is running on (or
+    //  was, an instant ago).
+    inline auto CurrentCpu() noexcept -> unsigned {
+     #if RANDOM_UTIL_HAS_RSEQ
+        if(__rseq_size > 0u) {
+            auto* rs = reinterpret_cast<const volatile struct rseq*>(
+                static_cast<char*>(__builtin_thread_pointer()) +
+                __rseq_offset
+                );
+            auto cpu = static_cast<std::int32_t>(rs->cpu_id);
+            if(cpu >= 0) { return static_cast<unsigned>(cpu); }
+        }
+     #endif
+     #if defined(__linux__)
+        int cpu = sched_getcpu();
+        if(cpu >= 0) { return static_cast<unsigned>(cpu); }
+     #endif
+        thread_local unsigned pseudoCpu = static_cast<unsigned>(
+            std::hash<std::thread::id>{}(std::this_thread::get_id())
+            );
+        return pseudoCpu;
+    }
+
+    //  Derives a SplitMix64 increment from random bits, forcing it odd and
+    //  rejecting patterns with too few bit transitions (as in Steele, Lea
+    //  and Flood, "Fast Splittable Pseudorandom Number Generators", 2014).
+    inline constexpr auto MixGamma(std::uint64_t z) noexcept
+        -> std::uint64_t
+    {
+        z = Mix64(z) | 1u;
+        auto x = z ^ (z >> 1);
+        unsigned transitions = 0;
+        for(; x; x &= x - 1u) { ++transitions; }
+        return transitions < 24u ? z ^ 0xaaaaaaaaaaaaaaaau : z;
+    }
+}
+
+class PerCpuEngine {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr auto min() noexcept -> result_type { return 0u; }
+    static constexpr auto max() noexcept -> result_type {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    template<typename SeedSeq = SeedSource::Seq>
+        explicit PerCpuEngine(SeedSeq&& seq = SeedSeq{}, std::size_t slots = 0)
+        {
+            if(slots == 0) {
+                slots = std::max(1u, std::thread::hardware_concurrency());
+            }
+            std::size_t n = 1;
+            while(n < slots) { n <<= 1; }
+            this->slotArray.reset(new Slot[n]);
+            this->mask = n - 1u;
+            auto gen = ForkGeneration();
+            this->generation.store(gen);
+            this->claimed.store(gen);
+            this->rekey(seq);
+        }
+
+    auto slots() const noexcept -> std::size_t { return this->mask + 1u; }
+
+    auto operator()() noexcept -> result_type {
+        auto gen = ForkGeneration();
+        if(this->generation.load(std::memory_order_acquire) != gen) {
+            this->rekeyAfterFork(gen);
+        }
+        auto& slot = this->slotArray[
+            RandomUtilDetail::CurrentCpu() & this->mask
+            ];
+        auto gamma = slot.gamma.load(std::memory_order_relaxed);
+        auto state = gamma +
+            slot.state.fetch_add(gamma, std::memory_order_relaxed);
+        return RandomUtilDetail::Mix64(state);
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> state{0};
+        std::atomic<std::uint64_t> gamma{1};
+    };
+
+    std::unique_ptr<Slot[]> slotArray;
+    std::size_t mask;
+
+    //  generation is the fork generation the slots are keyed for, and is
+    //  only published once rekeying for it has finished. claimed is the
+    //  generation some thread has taken on the job of rekeying for. Since
+    //  the latter is a generation number rather than a lock, a child forked
+    //  while a parent thread was mid-rekey can still claim its own.
+    std::atomic<std::uint64_t> generation;
+    std::atomic<std::uint64_t> claimed;
+
+    template<typename SeedSeq>
+        void rekey(SeedSeq& seq) {
+            std::mt19937_64 g{seq};
+            for(std::size_t i = 0; i <= this->mask; ++i) {
+                this->slotArray[i].state.store(
+                    g(), std::memory_order_relaxed
+                    );
+                this->slotArray[i].gamma.store(
+                    RandomUtilDetail::MixGamma(g()), std::memory_order_relaxed
+                    );
+            }
+        }
+
+    //  The first caller in a new fork generation rekeys every slot from the
+    //  process root. Other threads calling meanwhile wait for it rather
+    //  than carry on with state inherited from the parent.
+    void rekeyAfterFork(std::uint64_t gen) noexcept {
+        auto seen = this->claimed.load(std::memory_order_relaxed);
+        while(seen != gen) {
+            if(this->claimed.compare_exchange_weak(seen, gen)) {
+                auto seq = RandomUtilDetail::SpawnProcessSeq(gen);
+                this->rekey(seq);
+                this->generation.store(gen, std::memory_order_release);
+                return;
+            }
+        }
+        while(this->generation.load(std::memory_order_acquire) != gen) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+inline auto GlobalEngine() -> PerCpuEngine& {
+    static PerCpuEngine engine;
+    return engine;
+}
+
+/*---- Philox4x32 -------------------------------------------------------------
+ *
+ *  Philox4x32 is the Philox4x32-10 counter-based engine of Salmon et al.
+ *  ("Parallel Random Numbers: As Easy as 1, 2, 3", SC11). Instead of
+ *  evolving a state, it computes its output as a keyed bijection of a
+ *  128-bit counter: Block(counter, key) returns 4 random 32-bit words. So
+ *  any position of any stream can be reached in O(1), and two engines with
+ *  different keys (or disjoint counter ranges) are independent streams.
+ *  It passes BigCrush and needs only 24 bytes of state.
+ *
+ *  Here, the upper 64 bits of the counter select a stream and the lower 64
+ *  count blocks within it, giving 2^64 streams of 2^66 values per key.
+ *
+ *  Type definitions:
+ *      Counter: std::array<std::uint32_t,4> (least significant word first)
+ *      Key: std::array<std::uint32_t,2>
+ *
+ *  Static methods:
+ *      Block(counter, key): the raw 10-round Philox bijection
+ *
+ *  Constructors:
+ *      Philox4x32(SeedSeq&& seq = SeedSource::Seq{}, stream = 0):
+ *          Draws the key from a SeedSequence.
+ *      Philox4x32(Key key, stream = 0):
+ *          Uses the key given.
+ *
+ *  Besides the UniformRandomBitGenerator interface (32-bit output), there
+ *  are key(), stream(), discard(n) and seek(i), the last of which jumps to
+ *  the i-th value of the stream.
+ */
+
+class Philox4x32 {
+public:
+    using result_type = std::uint32_t;
+    using Counter = std::array<std::uint32_t,4>;
+    using Key = std::array<std::uint32_t,2>;
+
+    static constexpr unsigned kRounds = 10;
+
+    static constexpr auto min() noexcept -> result_type { return 0u; }
+    static constexpr auto max() noexcept -> result_type {
+        return 0xffffffffu;
+    }
+
+    static constexpr auto Block(Counter c, Key k) noexcept -> Counter {
+        for(unsigned r = 0; r < kRounds; ++r) {
+            std::uint64_t p0 = std::uint64_t{0xd2511f53u} * c[0];
+            std::uint64_t p1 = std::uint64_t{0xcd9e8d57u} * c[2];
+            c = {
+                static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+                static_cast<std::uint32_t>(p1),
+                static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+                static_cast<std::uint32_t>(p0)
+                };
+            k[0] += 0x9e3779b9u;
+            k[1] += 0xbb67ae85u;
+        }
+        return c;
+    }
+
+    template<
+        typename SeedSeq = SeedSource::Seq,
+        typename = std::enable_if_t<
+            !std::is_same_v<std::decay_t<SeedSeq>,Key> &&
+            !std::is_same_v<std::decay_t<SeedSeq>,Philox4x32>
+            >
+        >
+        explicit Philox4x32(
+            SeedSeq&& seq = SeedSeq{}, std::uint64_t stream = 0
+            ):
+            Philox4x32{MakeKey(seq), stream} {}
+
+    explicit constexpr Philox4x32(Key key, std::uint64_t stream = 0) noexcept:
+        k{key}, streamId{stream} {}
+
+    constexpr auto key() const noexcept -> Key { return this->k; }
+    constexpr auto stream() const noexcept -> std::uint64_t {
+        return this->streamId;
+    }
+
+    auto operator()() noexcept -> result_type {
+        if(this->lane == 4u) {
+            this->buffer = Block(this->counter(this->blockIndex++), this->k);
+            this->lane = 0;
+        }
+        return this->buffer[this->lane++];
+    }
+
+    void seek(std::uint64_t i) noexcept {
+        this->blockIndex = i / 4u;
+        this->lane = 4;
+        if(i % 4u) {
+            this->buffer = Block(this->counter(this->blockIndex++), this->k);
+            this->lane = static_cast<unsigned>(i % 4u);
+        }
+    }
+
+    void discard(unsigned long long n) noexcept {
+        this->seek(4u * this->blockIndex - (4u - this->lane) + n);
+    }
+
+    friend auto operator==(const Philox4x32& a, const Philox4x32& b)
+        noexcept -> bool
+    {
+        return a.k == b.k && a.streamId == b.streamId &&
+            4u * a.blockIndex - (4u - a.lane) ==
+            4u * b.blockIndex - (4u - b.lane);
+    }
+    friend auto operator!=(const Philox4x32& a, const Philox4x32& b)
+        noexcept -> bool { return !(a == b); }
+
+private:
+    Key k;
+    std::uint64_t streamId;
+    std::uint64_t blockIndex = 0;
+    unsigned lane = 4;
+    Counter buffer{};
+
+    template<typename SeedSeq>
+        static auto MakeKey(SeedSeq& seq) -> Key {
+            auto w = RandomUtilDetail::SeedWords<1>(seq)[0];
+            return {
+                static_cast<std::uint32_t>(w),
+                static_cast<std::uint32_t>(w >> 32)
+                };
+        }
+
+    constexpr auto counter(std::uint64_t block) const noexcept -> Counter {
+        return {
+            static_cast<std::uint32_t>(block),
+            static_cast<std::uint32_t>(block >> 32),
+            static_cast<std::uint32_t>(this->streamId),
+            static_cast<std::uint32_t>(this->streamId >> 32)
+            };
+    }
+};
+
+/*---- SharedRandom -----------------------------------------------------------
+ *
+ *  SharedRandom is a single logical stream of random 64-bit words that any
+ *  number of threads can consume concurrently. The stream is Philox4x32
+ *  output under one key: the value at position p is built from the two
+ *  32-bit words of lanes 2(p%2) and 2(p%2)+1 of Block(p/2, key).
+ *
+ *  Threads do not draw from the SharedRandom directly. Each creates its own
+ *  SharedRandom::Reader, which claims kBlockValues consecutive positions at
+ *  a time with one atomic fetch_add on the shared counter, expands them
+ *  into a local buffer, and serves values from there. (A Reader claims
+ *  its first block on construction and the next one as soon as a block
+ *  runs out, so position() is always exact.) So there is one
+ *  atomic operation per kBlockValues values, and no two readers ever see
+ *  the same position.
+ *
+ *  Which thread gets which block depends on scheduling, but the stream
+ *  itself is a fixed function of the key. Given the same key (e.g. from a
+ *  fixed SpawnSeq), the same positions always hold the same values.
+ *  Reader::position() tells you where a reader is, and at(p) recomputes
+ *  any value after the fact, which is useful for auditing a run.
+ *
+ *  Constructor args:
+ *      seq (SeedSequence, optional): source of the key
+ *          Defaults to a default-constructed SeedSource::Seq.
+ *
+ *  Methods:
+ *      at(p): returns the value at position p
+ *      claimed(): returns the number of positions claimed so far
+ *
+ *  Reader (constructed from a SharedRandom&, which must outlive it):
+ *      A UniformRandomBitGenerator with 64-bit output.
+ *      position(): the position of the next value it will return
+ *
+ *  Example:
+ *      SharedRandom shared{SeedSource::SpawnSeq::FromKey(2024)};
+ *      std::vector<std::thread> threads;
+ *      for(int t = 0; t < 16; ++t) {
+ *          threads.emplace_back([&shared] {
+ *              SharedRandom::Reader rng{shared};
+ *              std::normal_distribution<double> dis;
+ *              for(int i = 0; i < 1'000'000; ++i) { use(dis(rng)); }
+ *          });
+ *      }
+ */
+
+namespace RandomUtilDetail {
+
+    //  Writes positions [first,first + count) of the 64-bit stream that
+    //  SharedRandom and InterprocessRandom expand from a Philox key, where
+    //  position p comes from lanes 2(p%2) and 2(p%2)+1 of Block(p/2, key).
+    //  first and count must be even.
+    inline void PhiloxStream64(
+        const Philox4x32::Key& key, std::uint64_t first, std::uint64_t* out,
+        std::size_t count
+        ) noexcept
+    {
+        auto ctr = first / 2u;
+        for(std::size_t j = 0; j < count; j += 2, ++ctr) {
+            auto b = Philox4x32::Block(
+                {
+                    static_cast<std::uint32_t>(ctr),
+                    static_cast<std::uint32_t>(ctr >> 32),
+                    0u, 0u
+                },
+                key
+                );
+            out[j] = std::uint64_t{b[1]} << 32 | b[0];
+            out[j + 1] = std::uint64_t{b[3]} << 32 | b[2];
+        }
+    }
+}
+
+class SharedRandom {
+public:
+    static constexpr std::size_t kBlockValues = 128;
+
+    class Reader;
+
+    template<typename SeedSeq = SeedSource::Seq>
+        explicit SharedRandom(SeedSeq&& seq = SeedSeq{}):
+            engine{std::forward<SeedSeq>(seq)} {}
+
+    auto at(std::uint64_t p) const noexcept -> std::uint64_t {
+        std::uint64_t pair[2];
+        RandomUtilDetail::PhiloxStream64(
+            this->engine.key(), p & ~std::uint64_t{1}, pair, 2
+            );
+        return pair[p & 1u];
+    }
+
+    auto claimed() const noexcept -> std::uint64_t {
+        return this->next.load(std::memory_order_relaxed) * kBlockValues;
+    }
+
+private:
+    Philox4x32 engine;
+    alignas(64) std::atomic<std::uint64_t> next{0};
+};
+
+class SharedRandom::Reader {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr auto min() noexcept -> result_type { return 0u; }
+    static constexpr auto max() noexcept -> result_type {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    explicit Reader(SharedRandom& shared) noexcept: shared{&shared} {
+        this->refill();
+    }
+
+    auto operator()() noexcept -> result_type {
+        auto x = this->buffer[this->i];
+        if(++this->i == kBlockValues) { this->refill(); }
+        return x;
+    }
+
+    auto position() const noexcept -> std::uint64_t {
+        return this->base + this->i;
+    }
+
+private:
+    SharedRandom* shared;
+    std::uint64_t base;
+    std::size_t i;
+    std::array<std::uint64_t,kBlockValues> buffer;
+
+    void refill() noexcept {
+        auto block = this->shared->next.fetch_add(
+            1, std::memory_order_relaxed
+            );
+        this->base = block * kBlockValues;
+        RandomUtilDetail::PhiloxStream64(
+            this->shared->engine.key(), this->base, this->buffer.data(),
+            kBlockValues
+            );
+        this->i = 0;
+    }
+};
+
+/*---- ThreadPool -------------------------------------------------------------
+ *
+ *  ThreadPool is a minimal fixed-size pool used as the default executor of
+ *  the parallel facilities in this header. Its main scheduling primitive
+ *  is parallelFor(count, fn), which calls fn(i) once for every i in
+ *  [0,count) across the pool and returns when all calls have finished.
+ *  The calling thread takes part in the work, so a pool of n threads owns
+ *  n - 1 workers. Nested parallelFor calls (from inside fn) are safe: the
+ *  caller only ever waits on indices that some running thread has already
+ *  claimed.
+ *
+ *  If any fn(i) throws, the remaining indices are skipped and the first
+ *  exception is rethrown by parallelFor.
+ *
+ *  For background work, submit(fn) queues fn() to run on a worker and
+ *  returns at once. fn must not throw. A pool with no workers (threads ==
+ *  1) runs it on the spot.
+ *
+ *  SequentialExecutor has the same interface and just runs everything on
+ *  the calling thread, which is handy for debugging and for checking that
+ *  parallel results do not depend on the thread count.
+ *
+ *  Constructor args:
+ *      threads (std::size_t, optional): total number of threads
+ *          Defaults to std::thread::hardware_concurrency().
+ *
+ *  Methods:
+ *      parallelFor(count, fn): as above
+ *      submit(fn): as above
+ *      threads(): the number of threads (including the caller's)
+ *
+ *  DefaultThreadPool() returns a process-wide pool of the default size,
+ *  created on first use.
+ */
+
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = 0) {
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        this->workers.reserve(threads - 1);
+        for(std::size_t i = 1; i < threads; ++i) {
+            this->workers.emplace_back([this] { this->work(); });
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock{this->mutex};
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        for(auto& worker: this->workers) { worker.join(); }
+    }
+
+    auto threads() const noexcept -> std::size_t {
+        return this->workers.size() + 1;
+    }
+
+    template<typename Function>
+        void parallelFor(std::size_t count, Function&& fn) {
+            if(count == 0) { return; }
+            auto helpers = std::min(this->workers.size(), count - 1);
+            if(helpers == 0) {
+                for(std::size_t i = 0; i < count; ++i) { fn(i); }
+                return;
+            }
+            auto job = std::make_shared<Job>();
+            job->count = count;
+            job->context = &fn;
+            job->call = [](void* context, std::size_t i) {
+                (*static_cast<std::remove_reference_t<Function>*>(context))(i);
+            };
+            {
+                std::lock_guard<std::mutex> lock{this->mutex};
+                for(std::size_t i = 0; i < helpers; ++i) {
+                    this->queue.emplace_back([job] { job->run(); });
+                }
+            }
+            if(helpers == 1) { this->wake.notify_one(); }
+            else { this->wake.notify_all(); }
+            job->run();
+            std::unique_lock<std::mutex> lock{job->mutex};
+            job->finished.wait(lock, [&job] {
+                return job->done == job->count;
+            });
+            if(job->error) { std::rethrow_exception(job->error); }
+        }
+
+    template<typename Function>
+        void submit(Function&& fn) {
+            if(this->workers.empty()) {
+                fn();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock{this->mutex};
+                this->queue.emplace_back(std::forward<Function>(fn));
+            }
+            this->wake.notify_one();
+        }
+
+private:
+    struct Job {
+        std::size_t count;
+        void* context;
+        void (*call)(void*, std::size_t);
+        std::atomic<std::size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        void run() noexcept {
+            std::size_t ran = 0;
+            for(;;) {
+                auto i = this->next.fetch_add(1, std::memory_order_relaxed);
+                if(i >= this->count) { break; }
+                ++ran;
+                if(this->failed.load(std::memory_order_relaxed)) { continue; }
+                try {
+                    this->call(this->context, i);
+                }
+                catch(...) {
+                    std::lock_guard<std::mutex> lock{this->mutex};
+                    if(!this->error) {
+                        this->error = std::current_exception();
+                    }
+                    this->failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if(ran == 0) { return; }
+            std::lock_guard<std::mutex> lock{this->mutex};
+            this->done += ran;
+            if(this->done == this->count) { this->finished.notify_all(); }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void work() {
+        for(;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{this->mutex};
+                this->wake.wait(lock, [this] {
+                    return this->stopping || !this->queue.empty();
+                });
+                if(this->queue.empty()) { return; }
+                task = std::move(this->queue.front());
+                this->queue.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+struct SequentialExecutor {
+    static constexpr auto threads() noexcept -> std::size_t { return 1u; }
+
+    template<typename Function>
+        void parallelFor(std::size_t count, Function&& fn) const {
+            for(std::size_t i = 0; i < count; ++i) { fn(i); }
+        }
+
+    template<typename Function>
+        void submit(Function&& fn) const { fn(); }
+};
+
+inline auto DefaultThreadPool() -> ThreadPool& {
+    static ThreadPool pool;
+    return pool;
+}
+
+/*---- ParallelFill -----------------------------------------------------------
+ *
+ *  ParallelFill fills a random access range with values from a
+ *  distribution, in parallel, such that the result depends only on the
+ *  seed and not on the executor or its number of threads.
+ *
+ *  The range is cut into chunks of kParallelFillChunk elements (a fixed
+ *  constant, never derived from the thread count). Chunk c is filled by a
+ *  fresh copy of the distribution drawing from Philox4x32{key, c}, where
+ *  key comes from the SeedSequence given. Chunks are therefore independent
+ *  streams, and whichever thread happens to run a chunk produces exactly
+ *  the same values for it. A SequentialExecutor, a 1-thread pool and a
+ *  128-thread pool all give bit-identical output.
+ *
+ *  For the output to be reproducible across runs, seq must of course be
+ *  deterministic (e.g. a SeedSource::SpawnSeq); the default
+ *  SeedSource::Seq{} is not.
+ *
+ *  Args:
+ *      bgnIt, endIt (random access iterators): output range
+ *      dis (Distribution): copied for each chunk
+ *      seq (SeedSequence): source of the Philox key
+ *      exec (optional): anything with parallelFor(count, fn), such as
+ *          ThreadPool or SequentialExecutor
+ *          Defaults to DefaultThreadPool().
+ *
+ *  Example:
+ *      std::vector<double> data(100'000'000);
+ *      auto seq = SeedSource::SpawnSeq::FromKey(42);
+ *      ParallelFill(
+ *          data.begin(), data.end(), std::normal_distribution<>{}, seq
+ *          );
+ */
+
+inline constexpr std::size_t kParallelFillChunk = std::size_t{1} << 14;
+
+namespace RandomUtilDetail {
+
+    //  Fills chunk c of the n-element range at bgnIt, the way ParallelFill
+    //  and FillAsync both do.
+    template<typename RandomIt, typename Distribution>
+        void FillChunk(
+            RandomIt bgnIt, std::size_t n, const Distribution& dis,
+            const Philox4x32::Key& key, std::size_t c
+            )
+        {
+            Philox4x32 g{key, c};
+            auto d = dis;
+            auto it = bgnIt + static_cast<std::ptrdiff_t>(
+                c * kParallelFillChunk
+                );
+            auto last = bgnIt + static_cast<std::ptrdiff_t>(
+                std::min(n, (c + 1) * kParallelFillChunk)
+                );
+            for(; it != last; ++it) { *it = d(g); }
+        }
+}
+
+template<
+    typename RandomIt, typename Distribution, typename SeedSeq,
+    typename Executor
+    >
+    void ParallelFill(
+        RandomIt bgnIt, RandomIt endIt, const Distribution& dis,
+        SeedSeq&& seq, Executor&& exec
+        )
+    {
+        auto key = Philox4x32{std::forward<SeedSeq>(seq)}.key();
+        auto n = static_cast<std::size_t>(endIt - bgnIt);
+        auto chunks = (n + kParallelFillChunk - 1) / kParallelFillChunk;
+        exec.parallelFor(chunks, [&](std::size_t c) {
+            RandomUtilDetail::FillChunk(bgnIt, n, dis, key, c);
+        });
+    }
+
+template<typename RandomIt, typename Distribution, typename SeedSeq>
+    void ParallelFill(
+        RandomIt bgnIt, RandomIt endIt, const Distribution& dis,
+        SeedSeq&& seq
+        )
+    {
+        ParallelFill(
+            bgnIt, endIt, dis, std::forward<SeedSeq>(seq),
+            DefaultThreadPool()
+            );
+    }
+
+/*---- MonteCarlo -------------------------------------------------------------
+ *
+ *  MonteCarlo is a namespace for running a sampling kernel many times in
+ *  parallel and reducing the results.
+ *
+ *  Run(nSamples, kernel, reducer, root, exec) calls kernel(g) nSamples
+ *  times and feeds each result to reducer.add(). The samples are grouped
+ *  into batches of kBatch, and batch b always draws from its own engine
+ *  seeded with root.spawn(b). So which values are sampled depends only on
+ *  root and nSamples, not on the executor or on which thread ends up
+ *  running which batch.
+ *
+ *  The batches are dealt out to the threads as contiguous ranges. A thread
+ *  that runs out of work steals the back half of another thread's range,
+ *  so uneven kernels still balance. Each thread reduces into its own copy
+ *  of reducer, and the copies are merged with merge() at the end, in
+ *  thread order. Note that floating-point sums can therefore differ in the
+ *  last bits between runs on a parallel executor, though integer counts
+ *  (such as Histogram's) are exact.
+ *
+ *  A reducer is any copyable type with add(value) and merge(other). Stats
+ *  and Histogram are provided:
+ *
+ *      Stats: count, mean and variance (Welford's method, merged with Chan
+ *          et al.'s formula), plus min and max
+ *          Methods: add, merge, count, mean, variance (unbiased), stddev,
+ *              standardError, min, max
+ *
+ *      Histogram(lo, hi, bins): equal-width bins over [lo,hi)
+ *          Values below lo count as underflow; values from hi up (and NaNs)
+ *          count as overflow. Merging histograms of different shapes throws
+ *          std::invalid_argument.
+ *          Methods: add, merge, bins, count(i), lower(i), underflow,
+ *              overflow, total
+ *
+ *  Run template args:
+ *      Engine (optional): the engine type seeded per batch
+ *          Defaults to MTEngineT.
+ *
+ *  Run args:
+ *      nSamples (std::uint64_t): number of kernel calls
+ *      kernel: callable taking Engine& and returning a value
+ *          It is called from several threads at once.
+ *      reducer: prototype accumulator (copied per thread)
+ *      root (SeedSource::SpawnSeq, optional): root of the batch seeds
+ *          Defaults to a fresh SpawnSeq (i.e. non-reproducible).
+ *      exec (optional): ThreadPool, SequentialExecutor or the like
+ *          Defaults to DefaultThreadPool().
+ *
+ *  Returns:
+ *      Reducer: the merged accumulator
+ *
+ *  Throws:
+ *      std::length_error: if there would be 2^32 batches or more
+ *
+ *  Example:
+ *      auto stats = MonteCarlo::Run(
+ *          100'000'000,
+ *          [](MTEngineT& g) {
+ *              std::uniform_real_distribution<> dis;
+ *              double x = dis(g), y = dis(g);
+ *              return x * x + y * y < 1.0 ? 4.0 : 0.0;
+ *              },
+ *          MonteCarlo::Stats{},
+ *          SeedSource::SpawnSeq::FromKey(7)
+ *          );
+ *      std::cout << stats.mean() << " +/- " << stats.standardError();
+ */
+
+namespace MonteCarlo {
+    inline constexpr std::uint64_t kBatch = 4096;
+
+    class Stats {
+    public:
+        void add(double x) noexcept {
+            ++this->n;
+            auto delta = x - this->m;
+            this->m += delta / static_cast<double>(this->n);
+            this->m2 += delta * (x - this->m);
+            this->lo = std::min(this->lo, x);
+            this->hi = std::max(this->hi, x);
+        }
+        void merge(const Stats& other) noexcept {
+            if(other.n == 0) { return; }
+            if(this->n == 0) { *this = other; return; }
+            auto na = static_cast<double>(this->n);
+            auto nb = static_cast<double>(other.n);
+            auto delta = other.m - this->m;
+            this->n += other.n;
+            auto nab = static_cast<double>(this->n);
+            this->m += delta * nb / nab;
+            this->m2 += other.m2 + delta * delta * na * nb / nab;
+            this->lo = std::min(this->lo, other.lo);
+            this->hi = std::max(this->hi, other.hi);
+        }
+
+        auto count() const noexcept -> std::uint64_t { return this->n; }
+        auto mean() const noexcept -> double { return this->m; }
+        auto variance() const noexcept -> double {
+            return this->n > 1 ?
+                this->m2 / static_cast<double>(this->n - 1) : 0.0;
+        }
+        auto stddev() const noexcept -> double {
+            return std::sqrt(this->variance());
+        }
+        auto standardError() const noexcept -> double {
+            return this->n > 0 ?
+                std::sqrt(this->variance() / static_cast<double>(this->n)) :
+                0.0;
+        }
+        auto min() const noexcept -> double { return this->lo; }
+        auto max() const noexcept -> double { return this->hi; }
+
+    private:
+        std::uint64_t n = 0;
+        double m = 0.0;
+        double m2 = 0.0;
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = -std::numeric_limits<double>::infinity();
+    };
+
+    class Histogram {
+    public:
+        Histogram(double lo, double hi, std::size_t bins):
+            lo{lo}, hi{hi}, counts(bins)
+        {
+            if(!(lo < hi) || !std::isfinite(hi - lo)) {
+                throw std::invalid_argument{
+                    "MonteCarlo::Histogram: need finite lo < hi"
+                    };
+            }
+            if(bins == 0) {
+                throw std::invalid_argument{
+                    "MonteCarlo::Histogram: need at least one bin"
+                    };
+            }
+            this->scale = static_cast<double>(bins) / (hi - lo);
+        }
+
+        void add(double x) noexcept {
+            if(x >= this->lo && x < this->hi) {
+                auto i = static_cast<std::size_t>(
+                    (x - this->lo) * this->scale
+                    );
+                ++this->counts[std::min(i, this->counts.size() - 1)];
+            }
+            else if(x < this->lo) { ++this->under; }
+            else { ++this->over; }
+        }
+        void merge(const Histogram& other) {
+            if(
+                other.lo != this->lo || other.hi != this->hi ||
+                other.counts.size() != this->counts.size()
+                )
+            {
+                throw std::invalid_argument{
+                    "MonteCarlo::Histogram: merging different shapes"
+                    };
+            }
+            for(std::size_t i = 0; i < this->counts.size(); ++i) {
+                this->counts[i] += other.counts[i];
+            }
+            this->under += other.under;
+            this->over += other.over;
+        }
+
+        auto bins() const noexcept -> std::size_t {
+            return this->counts.size();
+        }
+        auto count(std::size_t i) const -> std::uint64_t {
+            return this->counts.at(i);
+        }
+        auto lower(std::size_t i) const noexcept -> double {
+            return this->lo + static_cast<double>(i) / this->scale;
+        }
+        auto underflow() const noexcept -> std::uint64_t {
+            return this->under;
+        }
+        auto overflow() const noexcept -> std::uint64_t { return this->over; }
+        auto total() const noexcept -> std::uint64_t {
+            std::uint64_t t = this->under + this->over;
+            for(auto c: this->counts) { t += c; }
+            return t;
+        }
+
+    private:
+        double lo;
+        double hi;
+        double scale;
+        std::vector<std::uint64_t> counts;
+        std::uint64_t under = 0;
+        std::uint64_t over = 0;
+    };
+
+    template<
+        typename Engine = MTEngineT, typename Kernel, typename Reducer,
+        typename Executor
+        >
+        auto Run(
+            std::uint64_t nSamples, Kernel&& kernel, const Reducer& reducer,
+            const SeedSource::SpawnSeq& root, Executor&& exec
+            ) -> Reducer
+        {
+            //  Each worker's remaining batches [lo,hi) packed into one word
+            //  as hi << 32 | lo, so that both the owner (taking from the
+            //  front) and thieves (taking from the back) update it by CAS.
+            struct alignas(64) Range {
+                std::atomic<std::uint64_t> packed{0};
+            };
+
+            auto batches = (nSamples + kBatch - 1) / kBatch;
+            if(batches >= std::uint64_t{1} << 32) {
+                throw std::length_error{"MonteCarlo::Run: too many samples"};
+            }
+            auto workers = static_cast<std::size_t>(std::max<std::uint64_t>(
+                std::min<std::uint64_t>(exec.threads(), batches), 1
+                ));
+            std::unique_ptr<Range[]> ranges{new Range[workers]};
+            for(std::size_t w = 0; w < workers; ++w) {
+                auto lo = batches * w / workers;
+                auto hi = batches * (w + 1) / workers;
+                ranges[w].packed.store(
+                    hi << 32 | lo, std::memory_order_relaxed
+                    );
+            }
+            std::vector<Reducer> partial(workers, reducer);
+
+            auto runBatch = [&](std::uint64_t b, Reducer& acc) {
+                auto seq = root.spawn(b);
+                Engine g{seq};
+                auto n = std::min(kBatch, nSamples - b * kBatch);
+                for(std::uint64_t i = 0; i < n; ++i) { acc.add(kernel(g)); }
+            };
+            auto steal = [&](std::size_t w) -> bool {
+                for(std::size_t k = 1; k < workers; ++k) {
+                    auto& victim = ranges[(w + k) % workers].packed;
+                    auto cur = victim.load(std::memory_order_relaxed);
+                    for(;;) {
+                        auto lo = cur & 0xffffffffu, hi = cur >> 32;
+                        if(lo >= hi) { break; }
+                        auto mid = hi - (hi - lo + 1) / 2;
+                        if(
+                            victim.compare_exchange_weak(
+                                cur, mid << 32 | lo,
+                                std::memory_order_relaxed
+                                )
+                            )
+                        {
+                            ranges[w].packed.store(
+                                hi << 32 | mid, std::memory_order_relaxed
+                                );
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            };
+
+            exec.parallelFor(workers, [&](std::size_t w) {
+                auto& own = ranges[w].packed;
+                auto acc = reducer;
+                do {
+                    auto cur = own.load(std::memory_order_relaxed);
+                    for(;;) {
+                        auto lo = cur & 0xffffffffu, hi = cur >> 32;
+                        if(lo >= hi) { break; }
+                        if(
+                            own.compare_exchange_weak(
+                                cur, hi << 32 | (lo + 1),
+                                std::memory_order_relaxed
+                                )
+                            )
+                        {
+                            runBatch(lo, acc);
+                            cur = own.load(std::memory_order_relaxed);
+                        }
+                    }
+                } while(steal(w));
+                partial[w] = std::move(acc);
+            });
+
+            auto result = std::move(partial[0]);
+            for(std::size_t w = 1; w < workers; ++w) {
+                result.merge(partial[w]);
+            }
+            return result;
+        }
+
+    template<
+        typename Engine = MTEngineT, typename Kernel, typename Reducer
+        >
+        auto Run(
+            std::uint64_t nSamples, Kernel&& kernel, const Reducer& reducer,
+            const SeedSource::SpawnSeq& root = SeedSource::SpawnSeq{}
+            ) -> Reducer
+        {
+            return Run<Engine>(
+                nSamples, std::forward<Kernel>(kernel), reducer, root,
+                DefaultThreadPool()
+                );
+        }
+}
+
+/*---- RandomService ----------------------------------------------------------
+ *
+ *  RandomService moves random number generation off latency-critical
+ *  threads entirely. A helper thread owns the engine and keeps one lock-free
+ *  single-producer/single-consumer ring per consumer topped up with values
+ *  drawn in advance. A consumer only pays for a ring pop: two loads, one
+ *  store and a copy, with no state regeneration (such as the Mersenne
+ *  Twister's 2.5 KB twist) ever landing on its critical path.
+ *
+ *  The rings have a power-of-two capacity, and the producer's and
+ *  consumer's indices live on separate cache lines. Each side also caches
+ *  the other side's index, so in steady state a pop touches shared memory
+ *  only when the cached view runs dry.
+ *
+ *  The producer visits the rings round-robin, publishing at most kBatch
+ *  values to each before moving on, so a ring being drained never waits
+ *  for more than one batch per sibling ring, however large they are.
+ *  When every ring is full, the producer spins briefly and then sleeps for
+ *  kIdleSleep, so size capacity for at least that long a burst of
+ *  consumption. Back-pressure statistics come per consumer:
+ *      underruns: pops (or failed tryPops) that found the ring empty
+ *      stalls: times the ring filled up, i.e. the producer found it full
+ *          after having had room on its previous visit
+ *  Frequent underruns mean the producer cannot keep up (or is asleep too
+ *  long). Stalls are harmless on their own: they count the bursts the ring
+ *  absorbed and then caught up on.
+ *
+ *  Template args:
+ *      Distribution (optional): what to draw for the consumers
+ *          Called as dis(engine) on the helper thread. Defaults to raw
+ *          64-bit words.
+ *
+ *  Constructor args:
+ *      consumers (std::size_t): number of rings (one per consumer thread)
+ *      dis (Distribution, optional): distribution object
+ *      capacity (std::size_t, optional): values per ring
+ *          Rounded up to a power of two. Defaults to 4096.
+ *      seq (SeedSequence, optional): seeds the helper thread's engine
+ *          Defaults to a default-constructed SeedSource::Seq.
+ *
+ *  Methods:
+ *      consumer(i): returns the Consumer for ring i
+ *          Each Consumer must only ever be popped from by one thread at a
+ *          time.
+ *      produced(): total values published so far
+ *
+ *  Consumer methods:
+ *      tryPop(T& out) -> bool: takes a value if one is ready
+ *      pop() -> T: takes a value, spinning if the ring is empty
+ *      operator()(): same as pop()
+ *          With the default Distribution, this makes a Consumer a
+ *          UniformRandomBitGenerator.
+ *      underruns(), stalls(): as above
+ *
+ *  Example:
+ *      RandomService<std::uniform_real_distribution<double>> rng{2};
+ *      std::thread quoter{[&rng] {
+ *          auto& u = rng.consumer(0);
+ *          for(;;) { onTick(u.pop()); }
+ *      }};
+ */
+
+namespace RandomUtilDetail {
+
+    //  Tells the CPU we are in a spin-wait loop.
+    inline void CpuRelax() noexcept {
+     #if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+     #elif defined(__aarch64__)
+        asm volatile("yield");
+     #endif
+    }
+
+    //  The default RandomService distribution: raw 64-bit words.
+    struct RawBits {
+        using result_type = std::uint64_t;
+
+        template<typename URBG>
+            auto operator()(URBG& g) const -> result_type {
+                return Bits64(g);
+            }
+    };
+}
+
+template<typename Distribution = RandomUtilDetail::RawBits>
+    class RandomService {
+    public:
+        using result_type = typename Distribution::result_type;
+
+        static constexpr std::chrono::microseconds kIdleSleep{20};
+        static constexpr std::size_t kBatch = 64;
+
+        class Consumer {
+        public:
+            using result_type = RandomService::result_type;
+
+            static constexpr auto min() noexcept -> result_type {
+                return std::numeric_limits<result_type>::min();
+            }
+            static constexpr auto max() noexcept -> result_type {
+                return std::numeric_limits<result_type>::max();
+            }
+
+            auto tryPop(result_type& out) noexcept -> bool {
+                if(this->head == this->cachedTail) {
+                    this->cachedTail = this->tail.load(
+                        std::memory_order_acquire
+                        );
+                    if(this->head == this->cachedTail) {
+                        ++this->misses;
+                        return false;
+                    }
+                }
+                out = this->slots[this->head & this->mask];
+                this->headShared.store(
+                    ++this->head, std::memory_order_release
+                    );
+                return true;
+            }
+
+            auto pop() noexcept -> result_type {
+                result_type out;
+                if(!this->tryPop(out)) {
+                    do {
+                        RandomUtilDetail::CpuRelax();
+                        this->cachedTail = this->tail.load(
+                            std::memory_order_acquire
+                            );
+                    } while(this->head == this->cachedTail);
+                    out = this->slots[this->head & this->mask];
+                    this->headShared.store(
+                        ++this->head, std::memory_order_release
+                        );
+                }
+                return out;
+            }
+
+            auto operator()() noexcept -> result_type { return this->pop(); }
+
+            auto underruns() const noexcept -> std::uint64_t {
+                return this->misses;
+            }
+            auto stalls() const noexcept -> std::uint64_t {
+                return this->fullPasses.load(std::memory_order_relaxed);
+            }
+
+        private:
+            friend class RandomService;
+
+            std::unique_ptr<result_type[]> slots;
+            std::size_t mask = 0;
+
+            //  Consumer side.
+            alignas(64) std::size_t head = 0;
+            std::size_t cachedTail = 0;
+            std::uint64_t misses = 0;
+            std::atomic<std::size_t> headShared{0};
+
+            //  Producer side.
+            alignas(64) std::atomic<std::size_t> tail{0};
+            std::size_t cachedHead = 0;
+            bool full = false;
+            std::atomic<std::uint64_t> fullPasses{0};
+        };
+
+        template<typename SeedSeq = SeedSource::Seq>
+            explicit RandomService(
+                std::size_t consumers, Distribution dis = Distribution{},
+                std::size_t capacity = 4096, SeedSeq&& seq = SeedSeq{}
+                ):
+                dis{std::move(dis)},
+                engine{seq},
+                rings{new Consumer[consumers]},
+                ringCount{consumers}
+            {
+                std::size_t size = 1;
+                while(size < capacity) { size <<= 1; }
+                for(std::size_t i = 0; i < consumers; ++i) {
+                    this->rings[i].slots.reset(new result_type[size]);
+                    this->rings[i].mask = size - 1;
+                }
+                this->producer = std::thread{[this] { this->produce(); }};
+            }
+        RandomService(const RandomService&) = delete;
+        auto operator=(const RandomService&) -> RandomService& = delete;
+        ~RandomService() {
+            this->stopping.store(true, std::memory_order_relaxed);
+            this->producer.join();
+        }
+
+        auto consumer(std::size_t i) -> Consumer& {
+            if(i >= this->ringCount) {
+                throw std::out_of_range{"RandomService: no such consumer"};
+            }
+            return this->rings[i];
+        }
+
+        auto produced() const noexcept -> std::uint64_t {
+            return this->total.load(std::memory_order_relaxed);
+        }
+
+    private:
+        Distribution dis;
+        MTEngineT engine;
+        std::unique_ptr<Consumer[]> rings;
+        std::size_t ringCount;
+        std::atomic<bool> stopping{false};
+        std::atomic<std::uint64_t> total{0};
+        std::thread producer;
+
+        void produce() {
+            constexpr int kSpins = 256;
+            int idle = 0;
+            while(!this->stopping.load(std::memory_order_relaxed)) {
+                bool progress = false;
+                for(std::size_t i = 0; i < this->ringCount; ++i) {
+                    auto& r = this->rings[i];
+                    auto t = r.tail.load(std::memory_order_relaxed);
+                    if(t - r.cachedHead > r.mask) {
+                        r.cachedHead = r.headShared.load(
+                            std::memory_order_acquire
+                            );
+                        if(t - r.cachedHead > r.mask) {
+                            if(!r.full) {
+                                r.full = true;
+                                r.fullPasses.fetch_add(
+                                    1, std::memory_order_relaxed
+                                    );
+                            }
+                            continue;
+                        }
+                    }
+                    r.full = false;
+
+                    //  One batch per ring per pass, so that a consumer
+                    //  waiting on an empty ring is never held up by a
+                    //  large refill of another.
+                    auto n = std::min(r.cachedHead + r.mask + 1 - t, kBatch);
+                    for(auto stop = t + n; t != stop; ++t) {
+                        r.slots[t & r.mask] = this->dis(this->engine);
+                    }
+                    r.tail.store(t, std::memory_order_release);
+                    this->total.fetch_add(n, std::memory_order_relaxed);
+                    progress = true;
+                }
+                if(progress) { idle = 0; }
+                else if(idle < kSpins) {
+                    ++idle;
+                    RandomUtilDetail::CpuRelax();
+                }
+                else { std::this_thread::sleep_for(kIdleSleep); }
+            }
+        }
+    };
+
+/*---- IncrementalMTEngine ----------------------------------------------------
+ *
+ *  IncrementalMTEngine is a Mersenne Twister that produces exactly the same
+ *  sequence as std::mersenne_twister_engine with the same parameters (so
+ *  IncrementalMT19937 matches std::mt19937, and IncrementalMT19937_64
+ *  matches std::mt19937_64), but without the latency spike. The standard
+ *  engine regenerates its whole state (n words) on every n-th call and then
+ *  serves the next n calls from it. This one regenerates the single word it
+ *  is about to return on each call instead.
+ *
+ *  That gives the same result because word i of the new state depends only
+ *  on words i and i+1 and i+m (mod n), and the standard in-place twist
+ *  already reads the new values for indices that wrap around past n. In the
+ *  incremental version, those are precisely the words that have already
+ *  been regenerated this round, while the others still hold their old
+ *  values. The cost per call is the same, only without the 2.5 KB burst.
+ *
+ *  Seeding (by value or by SeedSequence, including the all-zero state fix)
+ *  follows the standard exactly, as does the default seed. Note that this
+ *  means a default-constructed IncrementalMTEngine is NOT randomly seeded
+ *  the way other engines in this header are: pass it a SeedSource::Seq (or
+ *  use MakeIncrementalMTEngine) for that.
+ *
+ *  Type definitions:
+ *      IncrementalMT19937, IncrementalMT19937_64: as above
+ *      IncrementalMT<Engine>::type: the incremental version of a
+ *          std::mersenne_twister_engine type
+ *      IncrementalMTEngineT: the incremental version of MTEngineT
+ *
+ *  Function definitions:
+ *      MakeIncrementalMTEngine(flags = SeedSource::kAll):
+ *          Like MakeMTEngine, but returns an IncrementalMTEngineT.
+ *
+ *  Example:
+ *      std::mt19937 a{42};
+ *      IncrementalMT19937 b{42};
+ *      for(int i = 0; i < 10000; ++i) { assert(a() == b()); }
+ */
+
+template<
+    typename UInt, std::size_t W, std::size_t N, std::size_t M,
+    std::size_t R, UInt A, std::size_t U, UInt D, std::size_t S, UInt B,
+    std::size_t T, UInt C, std::size_t L, UInt F
+    >
+    class IncrementalMTEngine {
+    public:
+        static_assert(std::is_unsigned_v<UInt>);
+        static_assert(0u < M && M <= N && R <= W);
+        static_assert(2u <= W && W <= std::numeric_limits<UInt>::digits);
+
+        using result_type = UInt;
+
+        static constexpr std::size_t word_size = W;
+        static constexpr std::size_t state_size = N;
+        static constexpr std::size_t shift_size = M;
+        static constexpr std::size_t mask_bits = R;
+        static constexpr result_type default_seed = 5489u;
+
+        static constexpr auto min() noexcept -> result_type { return 0u; }
+        static constexpr auto max() noexcept -> result_type { return kMask; }
+
+        IncrementalMTEngine(): IncrementalMTEngine{default_seed} {}
+        explicit IncrementalMTEngine(result_type value) { this->seed(value); }
+        template<
+            typename SeedSeq,
+            typename = std::enable_if_t<
+                !std::is_convertible_v<SeedSeq,result_type> &&
+                !std::is_same_v<std::decay_t<SeedSeq>,IncrementalMTEngine>
+                >
+            >
+            explicit IncrementalMTEngine(SeedSeq&& seq) { this->seed(seq); }
+
+        void seed(result_type value = default_seed) {
+            this->x[0] = value & kMask;
+            for(std::size_t i = 1; i < N; ++i) {
+                auto prev = this->x[i - 1];
+                this->x[i] = static_cast<UInt>(
+                    F * (prev ^ (prev >> (W - 2))) + i
+                    ) & kMask;
+            }
+            this->i = 0;
+        }
+
+        template<
+            typename SeedSeq,
+            typename = std::enable_if_t<
+                !std::is_convertible_v<SeedSeq,result_type> &&
+                !std::is_same_v<std::decay_t<SeedSeq>,IncrementalMTEngine>
+                >
+            >
+            void seed(SeedSeq&& seq) {
+                constexpr std::size_t kWords = (W + 31) / 32;
+                std::array<std::uint_least32_t,N * kWords> words;
+                seq.generate(words.begin(), words.end());
+                bool zero = true;
+                for(std::size_t j = 0; j < N; ++j) {
+                    UInt sum = 0;
+                    for(std::size_t k = kWords; k-- > 0;) {
+                        if constexpr(std::numeric_limits<UInt>::digits > 32) {
+                            sum <<= 32;
+                        }
+                        sum |= static_cast<UInt>(
+                            words[kWords * j + k] & 0xffffffffu
+                            );
+                    }
+                    this->x[j] = sum & kMask;
+                    if(zero) {
+                        zero = j == 0 ?
+                            (this->x[0] & kUpper) == 0 : this->x[j] == 0;
+                    }
+                }
+                if(zero) { this->x[0] = UInt{1} << (W - 1); }
+                this->i = 0;
+            }
+
+        auto operator()() noexcept -> result_type {
+            auto j = this->i;
+            auto next = j + 1 == N ? 0 : j + 1;
+            auto far = j + M >= N ? j + M - N : j + M;
+            auto y = (this->x[j] & kUpper) | (this->x[next] & kLower);
+            auto z = this->x[far] ^ (y >> 1) ^ ((y & 1u) ? A : UInt{0});
+            this->x[j] = z;
+            this->i = next;
+            z ^= (z >> U) & D;
+            z ^= (z << S) & B;
+            z ^= (z << T) & C;
+            z ^= z >> L;
+            return z & kMask;
+        }
+
+        void discard(unsigned long long n) noexcept {
+            for(; n > 0; --n) { (*this)(); }
+        }
+
+        friend auto operator==(
+            const IncrementalMTEngine& a, const IncrementalMTEngine& b
+            ) noexcept -> bool
+        {
+            return a.i == b.i && a.x == b.x;
+        }
+        friend auto operator!=(
+            const IncrementalMTEngine& a, const IncrementalMTEngine& b
+            ) noexcept -> bool
+        {
+            return !(a == b);
+        }
+
+    private:
+        static constexpr UInt kMask =
+            W == std::numeric_limits<UInt>::digits ?
+            ~UInt{0} : static_cast<UInt>((UInt{1} << W) - 1u);
+        static constexpr UInt kUpper =
+            static_cast<UInt>(~UInt{0} << R) & kMask;
+        static constexpr UInt kLower = static_cast<UInt>(~kUpper) & kMask;
+
+        std::array<UInt,N> x;
+        std::size_t i;
+    };
+
+template<typename Engine>
+    struct IncrementalMT;
+template<
+    typename UInt, std::size_t W, std::size_t N, std::size_t M,
+    std::size_t R, UInt A, std::size_t U, UInt D, std::size_t S, UInt B,
+    std::size_t T, UInt C, std::size_t L, UInt F
+    >
+    struct IncrementalMT<
+        std::mersenne_twister_engine<UInt,W,N,M,R,A,U,D,S,B,T,C,L,F>
+        >
+    {
+        using type = IncrementalMTEngine<UInt,W,N,M,R,A,U,D,S,B,T,C,L,F>;
+    };
+
+using IncrementalMT19937 = typename IncrementalMT<std::mt19937>::type;
+using IncrementalMT19937_64 = typename IncrementalMT<std::mt19937_64>::type;
+using IncrementalMTEngineT = typename IncrementalMT<MTEngineT>::type;
+
+inline auto MakeIncrementalMTEngine(SeedSource::Flags flags = SeedSource::kAll)
+        -> IncrementalMTEngineT
+    {
+        SeedSource::Seq seq(flags);
+        return IncrementalMTEngineT(seq);
+    }
+
+/*---- NUMA placement ---------------------------------------------------------
+ *
+ *  On machines with several NUMA nodes, memory is placed on a node when a
+ *  page is first written, normally by whoever allocated it. Buffers that a
+ *  main thread allocates and workers then fill or read end up remote to
+ *  most of those workers. These helpers let random data live where it is
+ *  used. (ThreadEngine() already allocates each engine from its own
+ *  thread for the same reason.)
+ *
+ *  CurrentNumaNode() returns the node of the CPU the calling thread is
+ *  running on (0 where this cannot be determined).
+ *
+ *  NumaBuffer<T> is a fixed-size array of count elements of a trivial type
+ *  T, in freshly mapped pages that start out zeroed and untouched. Its
+ *  placement is one of:
+ *      kFirstTouch (the default): each page goes to the node of the first
+ *          thread to write to it
+ *      a node number: the pages prefer that node (via mbind); bound()
+ *          tells you whether the kernel accepted this
+ *  NumaBuffer<T>::Local(count) binds to the caller's current node.
+ *
+ *  A first-touch NumaBuffer pairs naturally with ParallelFill. The buffer
+ *  is page-aligned, so when kParallelFillChunk * sizeof(T) is a multiple
+ *  of the page size (always, with 4 KiB pages; only if sizeof(T) is a
+ *  multiple of 4 with 64 KiB pages), each chunk's pages land on the node
+ *  of the worker that generated it and no page is shared between two
+ *  chunks. Otherwise a page straddling two chunks goes to whichever of
+ *  their workers writes to it first. To keep consumers local too, have
+ *  each worker consume the same ranges it filled, or give every worker a
+ *  Local buffer of its own.
+ *
+ *  Methods:
+ *      data(), size(), empty(), begin(), end(), operator[]
+ *      node(): the requested node (or kFirstTouch)
+ *      bound(): whether the node binding took effect
+ *
+ *  Throws:
+ *      std::bad_alloc: if the memory cannot be mapped
+ *
+ *  Example:
+ *      NumaBuffer<double> noise(std::size_t{1} << 28);
+ *      ParallelFill(
+ *          noise.begin(), noise.end(), std::normal_distribution<>{},
+ *          SeedSource::SpawnSeq::FromKey(1)
+ *          );
+ */
+
+inline auto CurrentNumaNode() noexcept -> int {
+ #if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+ #endif
+    return 0;
+}
+
+template<typename T>
+    class NumaBuffer {
+    public:
+        static_assert(
+            std::is_trivially_default_constructible_v<T> &&
+            std::is_trivially_destructible_v<T>,
+            "NumaBuffer holds trivial types only"
+            );
+
+        static constexpr int kFirstTouch = -1;
+
+        explicit NumaBuffer(std::size_t count = 0, int node = kFirstTouch):
+            count{count}, nodeId{node}
+        {
+            if(count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+                throw std::bad_alloc{};
+            }
+            if(count > 0) {
+                this->ptr = static_cast<T*>(RandomUtilDetail::NumaMap(
+                    count * sizeof(T), node, this->isBound
+                    ));
+            }
+        }
+        NumaBuffer(NumaBuffer&& other) noexcept:
+            ptr{std::exchange(other.ptr, nullptr)},
+            count{std::exchange(other.count, 0)},
+            nodeId{other.nodeId},
+            isBound{other.isBound} {}
+        auto operator=(NumaBuffer&& other) noexcept -> NumaBuffer& {
+            if(this != &other) {
+                this->release();
+                this->ptr = std::exchange(other.ptr, nullptr);
+                this->count = std::exchange(other.count, 0);
+                this->nodeId = other.nodeId;
+                this->isBound = other.isBound;
+            }
+            return *this;
+        }
+        ~NumaBuffer() { this->release(); }
+
+        static auto Local(std::size_t count) -> NumaBuffer {
+            return NumaBuffer{count, CurrentNumaNode()};
+        }
+
+        auto data() noexcept -> T* { return this->ptr; }
+        auto data() const noexcept -> const T* { return this->ptr; }
+        auto size() const noexcept -> std::size_t { return this->count; }
+        auto empty() const noexcept -> bool { return this->count == 0; }
+        auto begin() noexcept -> T* { return this->ptr; }
+        auto begin() const noexcept -> const T* { return this->ptr; }
+        auto end() noexcept -> T* { return this->ptr + this->count; }
+        auto end() const noexcept -> const T* {
+            return this->ptr + this->count;
+        }
+        auto operator[](std::size_t i) noexcept -> T& { return this->ptr[i]; }
+        auto operator[](std::size_t i) const noexcept -> const T& {
+            return this->ptr[i];
+        }
+
+        auto node() const noexcept -> int { return this->nodeId; }
+        auto bound() const noexcept -> bool { return this->isBound; }
+
+    private:
+        T* ptr = nullptr;
+        std::size_t count;
+        int nodeId;
+        bool isBound = false;
+
+        void release() noexcept {
+            if(this->ptr) {
+                RandomUtilDetail::NumaUnmap(
+                    this->ptr, this->count * sizeof(T)
+                    );
+            }
+        }
+    };
+
+/*---- Shuffle and Sample -----------------------------------------------------
+ *
+ *  Shuffle and Sample are parallel, reproducible counterparts of
+ *  std::shuffle and std::sample. Like ParallelFill, they take a
+ *  SeedSequence and an executor, split the work into pieces whose number
+ *  depends only on the input size, and draw each piece's randomness from
+ *  its own Philox4x32 stream, so the result is the same for any executor
+ *  and any number of threads.
+ *
+ *  Shuffle(bgnIt, endIt, seq, exec):
+ *      Uniformly permutes a random access range. The range is cut into P
+ *      parts (at most kShuffleParts). Each part sends each of its elements
+ *      to one of P buckets at random, and each bucket is then
+ *      Fisher-Yates shuffled on its own, which gives a uniform permutation
+ *      (Sanders, "Random Permutations on Distributed, External and
+ *      Hierarchical Memory", 1998). The value type must be default
+ *      constructible and move assignable, as n of them are held in a
+ *      temporary buffer.
+ *
+ *  Sample(bgnIt, endIt, outIt, k, seq, exec):
+ *      Copies a uniformly random subset of min(k, n) elements of a random
+ *      access range to outIt, in their original order, and returns the end
+ *      of the output. Each element gets a random 64-bit key that depends
+ *      only on its position, and the k smallest keys are selected (first
+ *      per chunk of kParallelFillChunk elements, then overall).
+ *
+ *  As with ParallelFill, exec may be omitted to use DefaultThreadPool().
+ *
+ *  Execution policies:
+ *      When <execution> is available (see RANDOM_UTIL_HAS_EXECUTION at the
+ *      top of this header), Shuffle, Sample and ParallelFill also accept a
+ *      standard execution policy as their first argument in place of an
+ *      executor:
+ *          std::execution::seq (and unseq) run on the calling thread;
+ *          std::execution::par and par_unseq use DefaultThreadPool().
+ *      Whichever policy you choose, the output is identical, so a call
+ *      site can be switched between them without changing its results.
+ *
+ *  Example:
+ *      #include <execution>
+ *      #include "random_util.hpp"
+ *      ...
+ *      auto seq = SeedSource::SpawnSeq::FromKey(99);
+ *      Shuffle(std::execution::par, deck.begin(), deck.end(), seq);
+ *      std::vector<Row> training;
+ *      Sample(
+ *          std::execution::par, rows.begin(), rows.end(),
+ *          std::back_inserter(training), 10'000, seq.spawn(1)
+ *          );
+ */
+
+inline constexpr std::size_t kShuffleParts = 256;
+
+namespace RandomUtilDetail {
+
+    //  The first index of part i when n elements are split into k parts of
+    //  nearly equal size.
+    inline constexpr auto PartBegin(
+        std::size_t n, std::size_t k, std::size_t i
+        ) noexcept -> std::size_t
+    {
+        return n / k * i + std::min(i, n % k);
+    }
+
+    template<typename RandomIt, typename URBG>
+        void FisherYates(RandomIt bgnIt, std::size_t n, URBG& g) {
+            using std::swap;
+            for(std::size_t i = n; i > 1; --i) {
+                auto j = static_cast<std::ptrdiff_t>(Bounded(g, i));
+                swap(bgnIt[static_cast<std::ptrdiff_t>(i - 1)], bgnIt[j]);
+            }
+        }
+}
+
+template<typename RandomIt, typename SeedSeq, typename Executor>
+    void Shuffle(
+        RandomIt bgnIt, RandomIt endIt, SeedSeq&& seq, Executor&& exec
+        )
+    {
+        using RandomUtilDetail::Bounded;
+        using RandomUtilDetail::PartBegin;
+        using Value = typename std::iterator_traits<RandomIt>::value_type;
+
+        auto key = Philox4x32{std::forward<SeedSeq>(seq)}.key();
+        auto n = static_cast<std::size_t>(endIt - bgnIt);
+        auto parts = std::min(
+            (n + kParallelFillChunk - 1) / kParallelFillChunk, kShuffleParts
+            );
+        if(parts <= 1) {
+            Philox4x32 g{key, 0};
+            RandomUtilDetail::FisherYates(bgnIt, n, g);
+            return;
+        }
+
+        //  Pass 1: count how many elements each part sends to each bucket.
+        //  Pass 2 replays the same draws to scatter them.
+        std::vector<std::size_t> offsets(parts * parts);
+        exec.parallelFor(parts, [&](std::size_t c) {
+            Philox4x32 g{key, c};
+            auto* row = &offsets[c * parts];
+            for(
+                auto i = PartBegin(n, parts, c);
+                i < PartBegin(n, parts, c + 1); ++i
+                )
+            {
+                ++row[Bounded(g, parts)];
+            }
+        });
+        std::vector<std::size_t> bucketBegin(parts + 1);
+        std::size_t pos = 0;
+        for(std::size_t b = 0; b < parts; ++b) {
+            bucketBegin[b] = pos;
+            for(std::size_t c = 0; c < parts; ++c) {
+                auto count = offsets[c * parts + b];
+                offsets[c * parts + b] = pos;
+                pos += count;
+            }
+        }
+        bucketBegin[parts] = n;
+
+        std::vector<Value> buffer(n);
+        exec.parallelFor(parts, [&](std::size_t c) {
+            Philox4x32 g{key, c};
+            auto* row = &offsets[c * parts];
+            for(
+                auto i = PartBegin(n, parts, c);
+                i < PartBegin(n, parts, c + 1); ++i
+                )
+            {
+                buffer[row[Bounded(g, parts)]++] = std::move(
+                    bgnIt[static_cast<std::ptrdiff_t>(i)]
+                    );
+            }
+        });
+        exec.parallelFor(parts, [&](std::size_t b) {
+            Philox4x32 g{key, parts + b};
+            auto first = buffer.begin() +
+                static_cast<std::ptrdiff_t>(bucketBegin[b]);
+            auto last = buffer.begin() +
+                static_cast<std::ptrdiff_t>(bucketBegin[b + 1]);
+            RandomUtilDetail::FisherYates(
+                first, static_cast<std::size_t>(last - first), g
+                );
+            std::move(
+                first, last,
+                bgnIt + static_cast<std::ptrdiff_t>(bucketBegin[b])
+                );
+        });
+    }
+
+template<typename RandomIt, typename SeedSeq>
+    void Shuffle(RandomIt bgnIt, RandomIt endIt, SeedSeq&& seq) {
+        Shuffle(
+            bgnIt, endIt, std::forward<SeedSeq>(seq), DefaultThreadPool()
+            );
+    }
+
+template<
+    typename RandomIt, typename OutputIt, typename SeedSeq,
+    typename Executor
+    >
+    auto Sample(
+        RandomIt bgnIt, RandomIt endIt, OutputIt outIt, std::size_t k,
+        SeedSeq&& seq, Executor&& exec
+        ) -> OutputIt
+    {
+        using Entry = std::pair<std::uint64_t,std::size_t>;
+
+        auto key = Philox4x32{std::forward<SeedSeq>(seq)}.key();
+        auto n = static_cast<std::size_t>(endIt - bgnIt);
+        k = std::min(k, n);
+        if(k == 0) { return outIt; }
+
+        //  Each chunk keeps its k smallest (key, index) pairs in a max-heap.
+        //  Element i's key is always Philox words 2i and 2i + 1, however
+        //  the chunks are laid out.
+        auto chunks = (n + kParallelFillChunk - 1) / kParallelFillChunk;
+        std::vector<std::vector<Entry>> best(chunks);
+        exec.parallelFor(chunks, [&](std::size_t c) {
+            auto first = c * kParallelFillChunk;
+            auto last = std::min(n, first + kParallelFillChunk);
+            Philox4x32 g{key, 0};
+            g.seek(2u * first);
+            auto& heap = best[c];
+            heap.reserve(std::min(k, last - first));
+            for(auto i = first; i < last; ++i) {
+                Entry e{RandomUtilDetail::Bits64(g), i};
+                if(heap.size() < k) {
+                    heap.push_back(e);
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                else if(e < heap.front()) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = e;
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        });
+
+        std::vector<Entry> all;
+        for(auto& heap: best) {
+            all.insert(all.end(), heap.begin(), heap.end());
+            std::vector<Entry>{}.swap(heap);
+        }
+        if(all.size() > k) {
+            auto kth = all.begin() + static_cast<std::ptrdiff_t>(k - 1);
+            std::nth_element(all.begin(), kth, all.end());
+            all.resize(k);
+        }
+        std::sort(
+            all.begin(), all.end(),
+            [](const Entry& a, const Entry& b) { return a.second < b.second; }
+            );
+        for(auto& e: all) {
+            *outIt = bgnIt[static_cast<std::ptrdiff_t>(e.second)];
+            ++outIt;
+        }
+        return outIt;
+    }
+
+template<typename RandomIt, typename OutputIt, typename SeedSeq>
+    auto Sample(
+        RandomIt bgnIt, RandomIt endIt, OutputIt outIt, std::size_t k,
+        SeedSeq&& seq
+        ) -> OutputIt
+    {
+        return Sample(
+            bgnIt, endIt, outIt, k, std::forward<SeedSeq>(seq),
+            DefaultThreadPool()
+            );
+    }
+
+#if RANDOM_UTIL_HAS_EXECUTION
+
+namespace RandomUtilDetail {
+    template<typename Policy>
+        using IfExecutionPolicy = std::enable_if_t<
+            std::is_execution_policy_v<std::decay_t<Policy>>
+            >;
+
+    //  Calls fn with the executor that stands in for a standard execution
+    //  policy: the calling thread for the sequenced ones, and
+    //  DefaultThreadPool() for the parallel ones.
+    template<typename Policy, typename Function>
+        decltype(auto) WithPolicyExecutor(Function&& fn) {
+            using P = std::decay_t<Policy>;
+            if constexpr(
+                std::is_same_v<P,std::execution::sequenced_policy>
+             #if __cpp_lib_execution >= 201902L
+                || std::is_same_v<P,std::execution::unsequenced_policy>
+             #endif
+                )
+            {
+                return fn(SequentialExecutor{});
+            }
+            else {
+                return fn(DefaultThreadPool());
+            }
+        }
+}
+
+template<
+    typename Policy, typename RandomIt, typename Distribution,
+    typename SeedSeq, typename = RandomUtilDetail::IfExecutionPolicy<Policy>
+    >
+    void ParallelFill(
+        Policy&&, RandomIt bgnIt, RandomIt endIt, const Distribution& dis,
+        SeedSeq&& seq
+        )
+    {
+        RandomUtilDetail::WithPolicyExecutor<Policy>([&](auto&& exec) {
+            ParallelFill(bgnIt, endIt, dis, std::forward<SeedSeq>(seq), exec);
+        });
+    }
+
+template<
+    typename Policy, typename RandomIt, typename SeedSeq,
+    typename = RandomUtilDetail::IfExecutionPolicy<Policy>
+    >
+    void Shuffle(Policy&&, RandomIt bgnIt, RandomIt endIt, SeedSeq&& seq) {
+        RandomUtilDetail::WithPolicyExecutor<Policy>([&](auto&& exec) {
+            Shuffle(bgnIt, endIt, std::forward<SeedSeq>(seq), exec);
+        });
+    }
+
+template<
+    typename Policy, typename RandomIt, typename OutputIt, typename SeedSeq,
+    typename = RandomUtilDetail::IfExecutionPolicy<Policy>
+    >
+    auto Sample(
+        Policy&&, RandomIt bgnIt, RandomIt endIt, OutputIt outIt,
+        std::size_t k, SeedSeq&& seq
+        ) -> OutputIt
+    {
+        return RandomUtilDetail::WithPolicyExecutor<Policy>(
+            [&](auto&& exec) {
+                return Sample(
+                    bgnIt, endIt, outIt, k, std::forward<SeedSeq>(seq), exec
+                    );
+            });
+    }
+
+#endif
+
+/*---- RandomStream and RandomView --------------------------------------------
+ *
+ *  RandomStream and RandomView turn an engine and a distribution into an
+ *  endless lazy sequence for use in C++20 range pipelines. Both generate
+ *  their values kBlock at a time into an internal buffer, and stepping
+ *  through the buffer costs no more than walking an array. So a pipeline
+ *  like take/transform/filter over them runs at close to bulk-fill speed.
+ *  For std::normal_distribution, std::exponential_distribution and
+ *  std::uniform_real_distribution, the block is filled by the same bulk
+ *  transforms that the rest of this header uses. These draw different
+ *  (equally distributed) values than calling dis(g) one at a time would.
+ *
+ *  RandomStream(g, dis) (requires coroutine support):
+ *      A coroutine returning a RandomGenerator<T>, a move-only input range.
+ *      The coroutine only resumes once per block because it co_yields a
+ *      whole block, which the generator's iterator then walks through. A
+ *      RandomGenerator can also be returned by coroutines of your own.
+ *      These may co_yield single values or std::arrays of them, and may
+ *      finish (ending the range).
+ *
+ *  RandomView(g, dis) (requires <ranges>):
+ *      A single-pass std::ranges::view with the buffer held in the view
+ *      itself and no coroutine frame at all. Its end() is
+ *      std::unreachable_sentinel.
+ *
+ *  Either way, the engine is held by reference and must outlive the range.
+ *
+ *  Example:
+ *      auto g = MakeMTEngine();
+ *      for(
+ *          double x:
+ *              RandomView(g, std::normal_distribution<>{})
+ *              | std::views::filter([](double x) { return x > 0.0; })
+ *              | std::views::take(10)
+ *          )
+ *      {
+ *          std::cout << x << '\n';
+ *      }
+ */
+
+namespace RandomUtilDetail {
+
+    //  Fills out[0,n) with values of dis, by bulk transform where one is
+    //  available for the distribution.
+    template<typename URBG, typename Distribution, typename T>
+        void FillBlock(URBG& g, Distribution& dis, T* out, std::size_t n) {
+            for(std::size_t i = 0; i < n; ++i) { out[i] = dis(g); }
+        }
+    template<typename URBG, typename Real>
+        void FillBlock(
+            URBG& g, std::normal_distribution<Real>& dis, Real* out,
+            std::size_t n
+            )
+        {
+            FillStandardNormal(g, out, n);
+            for(std::size_t i = 0; i < n; ++i) {
+                out[i] = dis.mean() + dis.stddev() * out[i];
+            }
+        }
+    template<typename URBG, typename Real>
+        void FillBlock(
+            URBG& g, std::exponential_distribution<Real>& dis, Real* out,
+            std::size_t n
+            )
+        {
+            FillStandardExponential(g, out, n);
+            auto scale = Real{1} / dis.lambda();
+            for(std::size_t i = 0; i < n; ++i) { out[i] *= scale; }
+        }
+    template<typename URBG, typename Real>
+        void FillBlock(
+            URBG& g, std::uniform_real_distribution<Real>& dis, Real* out,
+            std::size_t n
+            )
+        {
+            auto a = dis.a(), width = dis.b() - dis.a();
+            for(std::size_t i = 0; i < n; ++i) {
+                out[i] = a + width * static_cast<Real>(ToUnit(Bits64(g)));
+            }
+        }
+}
+
+#if RANDOM_UTIL_HAS_COROUTINES
+
+template<typename T>
+    class RandomGenerator {
+    public:
+        struct promise_type {
+            const T* first = nullptr;
+            const T* last = nullptr;
+            std::exception_ptr error;
+
+            auto get_return_object() -> RandomGenerator {
+                return RandomGenerator{
+                    std::coroutine_handle<promise_type>::from_promise(*this)
+                    };
+            }
+            auto initial_suspend() noexcept -> std::suspend_always {
+                return {};
+            }
+            auto final_suspend() noexcept -> std::suspend_always {
+                return {};
+            }
+            auto yield_value(const T& value) noexcept -> std::suspend_always {
+                this->first = &value;
+                this->last = &value + 1;
+                return {};
+            }
+            template<std::size_t N>
+                auto yield_value(const std::array<T,N>& block) noexcept
+                    -> std::suspend_always
+                {
+                    this->first = block.data();
+                    this->last = block.data() + N;
+                    return {};
+                }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept {
+                this->error = std::current_exception();
+            }
+        };
+
+        class Iterator {
+        public:
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            auto operator*() const noexcept -> const T& {
+                return *this->handle.promise().first;
+            }
+            auto operator++() -> Iterator& {
+                auto& p = this->handle.promise();
+                if(++p.first == p.last) { Advance(this->handle); }
+                return *this;
+            }
+            void operator++(int) { ++*this; }
+
+            friend auto operator==(const Iterator& it, std::default_sentinel_t)
+                noexcept -> bool
+            {
+                return it.handle.done();
+            }
+
+        private:
+            friend class RandomGenerator;
+
+            std::coroutine_handle<promise_type> handle;
+
+            explicit Iterator(std::coroutine_handle<promise_type> h) noexcept:
+                handle{h} {}
+        };
+
+        RandomGenerator(RandomGenerator&& other) noexcept:
+            handle{std::exchange(other.handle, nullptr)} {}
+        auto operator=(RandomGenerator&& other) noexcept -> RandomGenerator& {
+            if(this != &other) {
+                if(this->handle) { this->handle.destroy(); }
+                this->handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        ~RandomGenerator() {
+            if(this->handle) { this->handle.destroy(); }
+        }
+
+        auto begin() -> Iterator {
+            if(!this->started) {
+                this->started = true;
+                Advance(this->handle);
+            }
+            return Iterator{this->handle};
+        }
+        auto end() const noexcept -> std::default_sentinel_t { return {}; }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+        bool started = false;
+
+        explicit RandomGenerator(std::coroutine_handle<promise_type> h)
+            noexcept: handle{h} {}
+
+        //  Resumes the coroutine until it yields something non-empty or
+        //  finishes, rethrowing anything it threw.
+        static void Advance(std::coroutine_handle<promise_type> h) {
+            do {
+                h.resume();
+            } while(!h.done() && h.promise().first == h.promise().last);
+            if(h.done() && h.promise().error) {
+                std::rethrow_exception(std::exchange(h.promise().error, {}));
+            }
+        }
+    };
+
+inline constexpr std::size_t kRandomStreamBlock = 256;
+
+template<typename Engine, typename Distribution>
+    auto RandomStream(Engine& g, Distribution dis)
+        -> RandomGenerator<typename Distribution::result_type>
+    {
+        std::array<typename Distribution::result_type,kRandomStreamBlock>
+            block;
+        for(;;) {
+            RandomUtilDetail::FillBlock(g, dis, block.data(), block.size());
+            co_yield block;
+        }
+    }
+
+#endif
+
+#if RANDOM_UTIL_HAS_RANGES
+
+ #if RANDOM_UTIL_HAS_COROUTINES
+template<typename T>
+    inline constexpr bool std::ranges::enable_view<RandomGenerator<T>> = true;
+ #endif
+
+template<typename Engine, typename Distribution>
+    class RandomView:
+        public std::ranges::view_interface<RandomView<Engine,Distribution>>
+    {
+    public:
+        using value_type = typename Distribution::result_type;
+
+        static constexpr std::size_t kBlock = 256;
+
+        class Iterator {
+        public:
+            using value_type = RandomView::value_type;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+
+            auto operator*() const noexcept -> const value_type& {
+                return this->view->block[this->view->i];
+            }
+            auto operator++() -> Iterator& {
+                if(++this->view->i == kBlock) { this->view->refill(); }
+                return *this;
+            }
+            void operator++(int) { ++*this; }
+
+        private:
+            friend class RandomView;
+
+            RandomView* view = nullptr;
+
+            explicit Iterator(RandomView* v) noexcept: view{v} {}
+        };
+
+        RandomView() = default;
+        RandomView(Engine& g, Distribution dis = Distribution{}):
+            g{&g}, dis{std::move(dis)} {}
+
+        auto begin() -> Iterator {
+            if(this->i == kBlock) { this->refill(); }
+            return Iterator{this};
+        }
+        auto end() const noexcept -> std::unreachable_sentinel_t {
+            return {};
+        }
+
+    private:
+        Engine* g = nullptr;
+        Distribution dis;
+        std::size_t i = kBlock;
+        std::array<value_type,kBlock> block;
+
+        void refill() {
+            RandomUtilDetail::FillBlock(
+                *this->g, this->dis, this->block.data(), kBlock
+                );
+            this->i = 0;
+        }
+    };
+
+#endif
+
+/*---- FillAsync --------------------------------------------------------------
+ *
+ *  FillAsync is ParallelFill in the background. It queues the fill on an
+ *  executor and returns a std::future<void> at once, so that a large
+ *  generation job can overlap with I/O or other work. The chunks, streams
+ *  and seeding are exactly those of ParallelFill, so the finished range
+ *  holds the same values that ParallelFill(bgnIt, endIt, dis, seq) would
+ *  have written.
+ *
+ *  The work is spread over up to exec.threads() tasks submitted with
+ *  exec.submit(), each of which claims chunks from a shared counter until
+ *  none are left. The last one to finish makes the future ready (or
+ *  stores the first exception thrown, after which the remaining chunks
+ *  are skipped). With SequentialExecutor or a 1-thread ThreadPool, there
+ *  are no workers to hand the work to, so the fill happens before
+ *  FillAsync returns.
+ *
+ *  The range must stay alive and untouched until the future is ready.
+ *  Unlike the future of std::async, this one does not wait in its
+ *  destructor, so do not let it go out of scope unwaited-for while the
+ *  range can disappear. The distribution is copied.
+ *
+ *  Args:
+ *      bgnIt, endIt (random access iterators): output range
+ *      dis (Distribution): copied, then copied again for each chunk
+ *      seq (SeedSequence): source of the Philox key
+ *      exec (optional): anything with threads() and submit(fn)
+ *          Defaults to DefaultThreadPool().
+ *
+ *  Returns:
+ *      std::future<void>: ready once the range is filled
+ *
+ *  Example:
+ *      std::vector<float> a(n), b(n);
+ *      auto root = SeedSource::SpawnSeq::FromKey(5);
+ *      auto next = FillAsync(
+ *          a.begin(), a.end(), std::normal_distribution<float>{}, root
+ *          );
+ *      for(std::uint64_t i = 1; i < batches; ++i) {
+ *          next.get();
+ *          std::swap(a, b);
+ *          next = FillAsync(
+ *              a.begin(), a.end(), std::normal_distribution<float>{},
+ *              root.spawn(i)
+ *              );
+ *          file.write(b);  // overlaps with generating the next batch
+ *      }
+ */
+
+template<
+    typename RandomIt, typename Distribution, typename SeedSeq,
+    typename Executor
+    >
+    auto FillAsync(
+        RandomIt bgnIt, RandomIt endIt, const Distribution& dis,
+        SeedSeq&& seq, Executor&& exec
+        ) -> std::future<void>
+    {
+        struct State {
+            RandomIt bgnIt;
+            std::size_t n;
+            std::size_t chunks;
+            Distribution dis;
+            Philox4x32::Key key;
+            std::atomic<std::size_t> next{0};
+            std::atomic<std::size_t> left;
+            std::atomic<bool> failed{false};
+            std::mutex mutex;
+            std::exception_ptr error;
+            std::promise<void> done;
+
+            State(
+                RandomIt bgnIt, std::size_t n, const Distribution& dis,
+                Philox4x32::Key key
+                ):
+                bgnIt{bgnIt},
+                n{n},
+                chunks{(n + kParallelFillChunk - 1) / kParallelFillChunk},
+                dis{dis},
+                key{key},
+                left{this->chunks} {}
+
+            void run() noexcept {
+                std::size_t ran = 0;
+                for(;;) {
+                    auto c = this->next.fetch_add(
+                        1, std::memory_order_relaxed
+                        );
+                    if(c >= this->chunks) { break; }
+                    ++ran;
+                    if(this->failed.load(std::memory_order_relaxed)) {
+                        continue;
+                    }
+                    try {
+                        RandomUtilDetail::FillChunk(
+                            this->bgnIt, this->n, this->dis, this->key, c
+                            );
+                    }
+                    catch(...) {
+                        std::lock_guard<std::mutex> lock{this->mutex};
+                        if(!this->error) {
+                            this->error = std::current_exception();
+                        }
+                        this->failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                if(
+                    ran > 0 &&
+                    this->left.fetch_sub(ran, std::memory_order_acq_rel) ==
+                        ran
+                    )
+                {
+                    if(this->error) {
+                        this->done.set_exception(this->error);
+                    }
+                    else {
+                        this->done.set_value();
+                    }
+                }
+            }
+        };
+
+        auto state = std::make_shared<State>(
+            bgnIt, static_cast<std::size_t>(endIt - bgnIt), dis,
+            Philox4x32{std::forward<SeedSeq>(seq)}.key()
+            );
+        auto future = state->done.get_future();
+        if(state->chunks == 0) {
+            state->done.set_value();
+            return future;
+        }
+        auto tasks = std::min<std::size_t>(exec.threads(), state->chunks);
+        for(std::size_t i = 0; i < tasks; ++i) {
+            exec.submit([state] { state->run(); });
+        }
+        return future;
+    }
+
+template<typename RandomIt, typename Distribution, typename SeedSeq>
+    auto FillAsync(
+        RandomIt bgnIt, RandomIt endIt, const Distribution& dis,
+        SeedSeq&& seq
+        ) -> std::future<void>
+    {
+        return FillAsync(
+            bgnIt, endIt, dis, std::forward<SeedSeq>(seq),
+            DefaultThreadPool()
+            );
+    }
+
+/*---- InterprocessRandom -----------------------------------------------------
+ *
+ *  InterprocessRandom is SharedRandom for processes rather than threads. A
+ *  named POSIX shared memory segment holds the Philox key and the block
+ *  counter. Each process attaches to it, and its Readers claim blocks of
+ *  kBlockValues positions with a single atomic fetch_add on the shared
+ *  counter, with no other IPC per draw. The values at each position are
+ *  the same as those of a SharedRandom with the same key.
+ *
+ *  The first process to open a given name creates and initializes the
+ *  segment, drawing the key from the SeedSequence it passes. The others
+ *  just attach and ignore their seq. Each constructor holds an exclusive
+ *  flock on the segment while it checks or initializes it, so attaching
+ *  never races with initialization. Only a segment of exactly the right
+ *  size that is either all zeros or bears this class's magic number is
+ *  accepted; anything else is left untouched and reported.
+ *
+ *  Crash safety:
+ *      The kernel drops the flock of a process that dies, whatever its pid
+ *      namespace, so a crashed initializer cannot wedge later attachers:
+ *      the next one finds the segment not marked ready and starts over.
+ *      Blocks are never handed out twice. When a process dies, whatever
+ *      remains of the blocks its Readers had claimed is simply abandoned.
+ *      This leaves gaps in the sequence of positions used, but guarantees
+ *      that streams stay disjoint even if a "dead" process turns out to
+ *      be alive after all. Since nothing is ever reclaimed, the shared
+ *      counter is the only state processes need to agree on, and there is
+ *      no limit on how many may attach.
+ *
+ *  The segment outlives the processes using it until Remove(name) is
+ *  called. A forked child may keep using an inherited InterprocessRandom
+ *  (its Readers still claim blocks from the shared counter), though any
+ *  Reader it inherits holds a copy of its parent's current block, so it
+ *  should construct new Readers.
+ *
+ *  Constructor args:
+ *      name (const char*): shared memory object name, e.g. "/sim-rng"
+ *      seq (SeedSequence, optional): source of the key if creating
+ *          Defaults to a default-constructed SeedSource::Seq.
+ *
+ *  Methods:
+ *      at(p), claimed(): as for SharedRandom
+ *      Remove(name) (static): unlinks the named segment
+ *
+ *  Reader (constructed from an InterprocessRandom&, which must outlive it):
+ *      A UniformRandomBitGenerator with 64-bit output, plus position().
+ *
+ *  Throws:
+ *      std::system_error: if the segment cannot be opened or mapped
+ *      std::invalid_argument: if the name refers to some other segment
+ *
+ *  Availability: POSIX systems only.
+ *
+ *  Example:
+ *      //  in every worker process
+ *      InterprocessRandom shared{
+ *          "/sim-rng", SeedSource::SpawnSeq::FromKey(2024)
+ *          };
+ *      InterprocessRandom::Reader rng{shared};
+ *      std::normal_distribution<> dis;
+ *      for(;;) { simulate(dis(rng)); }
+ */
+
+#if RANDOM_UTIL_HAS_POSIX
+
+class InterprocessRandom {
+public:
+    static constexpr std::size_t kBlockValues = 1024;
+
+    class Reader;
+
+    template<typename SeedSeq = SeedSource::Seq>
+        explicit InterprocessRandom(
+            const char* name, SeedSeq&& seq = SeedSeq{}
+            )
+        {
+            int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+            if(fd < 0) { Fail("shm_open"); }
+            try {
+                this->attach(fd, seq);
+            }
+            catch(...) {
+                close(fd);
+                throw;
+            }
+            close(fd);
+        }
+    InterprocessRandom(const InterprocessRandom&) = delete;
+    auto operator=(const InterprocessRandom&) -> InterprocessRandom& = delete;
+    ~InterprocessRandom() { munmap(this->segment, sizeof(Segment)); }
+
+    static void Remove(const char* name) { shm_unlink(name); }
+
+    auto at(std::uint64_t p) const noexcept -> std::uint64_t {
+        std::uint64_t pair[2];
+        RandomUtilDetail::PhiloxStream64(
+            this->key(), p & ~std::uint64_t{1}, pair, 2
+            );
+        return pair[p & 1u];
+    }
+
+    auto claimed() const noexcept -> std::uint64_t {
+        return this->segment->next.load(std::memory_order_relaxed) *
+            kBlockValues;
+    }
+
+private:
+    static constexpr std::uint64_t kMagic = 0x52554950524e4731u;
+    static constexpr std::uint64_t kReady = 2;
+
+    //  The shared layout. Freshly truncated memory is all zeros, which is
+    //  the uninitialized state. Initialization writes magic first and
+    //  state last, so a segment with the magic but not kReady is one whose
+    //  initializer died part-way through.
+    struct Segment {
+        std::atomic<std::uint64_t> state;
+        std::uint64_t magic;
+        std::uint64_t blockValues;
+        std::uint32_t key[2];
+        alignas(64) std::atomic<std::uint64_t> next;
+    };
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+    static_assert(std::is_trivially_destructible_v<Segment>);
+
+    Segment* segment = nullptr;
+
+    [[noreturn]] static void Fail(const char* what) {
+        throw std::system_error{
+            errno, std::generic_category(),
+            std::string{"InterprocessRandom: "} + what
+            };
+    }
+
+    [[noreturn]] static void Incompatible() {
+        throw std::invalid_argument{
+            "InterprocessRandom: incompatible shared memory segment"
+            };
+    }
+
+    auto key() const noexcept -> Philox4x32::Key {
+        return {this->segment->key[0], this->segment->key[1]};
+    }
+
+    //  Maps the segment and initializes it if need be, all under an
+    //  exclusive flock. The mapping holds a reference to the open file, so
+    //  closing fd would not release the lock: it is dropped explicitly.
+    template<typename SeedSeq>
+        void attach(int fd, SeedSeq& seq) {
+            while(flock(fd, LOCK_EX) != 0) {
+                if(errno != EINTR) { Fail("flock"); }
+            }
+            struct stat st;
+            if(fstat(fd, &st) != 0) { Fail("fstat"); }
+            if(st.st_size == 0) {
+                if(ftruncate(fd, static_cast<off_t>(sizeof(Segment))) != 0) {
+                    Fail("ftruncate");
+                }
+            }
+            else if(st.st_size != static_cast<off_t>(sizeof(Segment))) {
+                Incompatible();
+            }
+            void* p = mmap(
+                nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0
+                );
+            if(p == MAP_FAILED) { Fail("mmap"); }
+            this->segment = static_cast<Segment*>(p);
+            try {
+                this->initialize(seq);
+            }
+            catch(...) {
+                munmap(p, sizeof(Segment));
+                throw;
+            }
+            flock(fd, LOCK_UN);
+        }
+
+    template<typename SeedSeq>
+        void initialize(SeedSeq& seq) {
+            auto& seg = *this->segment;
+            if(seg.magic == kMagic) {
+                if(seg.state.load(std::memory_order_acquire) == kReady) {
+                    if(seg.blockValues != kBlockValues) { Incompatible(); }
+                    return;
+                }
+            }
+            else {
+                auto b = reinterpret_cast<const unsigned char*>(&seg);
+                if(
+                    std::any_of(
+                        b, b + sizeof(Segment),
+                        [](unsigned char c) { return c != 0; }
+                        )
+                    )
+                {
+                    Incompatible();
+                }
+            }
+            auto k = Philox4x32{seq}.key();
+            seg.magic = kMagic;
+            seg.blockValues = kBlockValues;
+            //  Keep the compiler from sinking the magic below the key.
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            seg.key[0] = k[0];
+            seg.key[1] = k[1];
+            seg.next.store(0, std::memory_order_relaxed);
+            seg.state.store(kReady, std::memory_order_release);
+        }
+};
+
+class InterprocessRandom::Reader {
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr auto min() noexcept -> result_type { return 0u; }
+    static constexpr auto max() noexcept -> result_type {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    explicit Reader(InterprocessRandom& shared):
+        shared{&shared}, buffer{new std::uint64_t[kBlockValues]}
+    {
+        this->refill();
+    }
+
+    auto operator()() noexcept -> result_type {
+        auto x = this->buffer[this->i];
+        if(++this->i == kBlockValues) { this->refill(); }
+        return x;
+    }
+
+    auto position() const noexcept -> std::uint64_t {
+        return this->base + this->i;
+    }
+
+private:
+    InterprocessRandom* shared;
+    std::unique_ptr<std::uint64_t[]> buffer;
+    std::uint64_t base;
+    std::size_t i;
+
+    void refill() noexcept {
+        auto block = this->shared->segment->next.fetch_add(
+            1, std::memory_order_relaxed
+            );
+        this->base = block * kBlockValues;
+        RandomUtilDetail::PhiloxStream64(
+            this->shared->key(), this->base, this->buffer.get(),
+            kBlockValues
+            );
+        this->i = 0;
+    }
+};
+
+#endif
+
 #endif